@@ -0,0 +1,1869 @@
+// Conway's Game of Life for Commodore 64 - the portable core
+// By Ifor Evans
+
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "life.h"
+
+// Use the hand-written 6502 row kernel in calc_next_gen (0 = portable C loop)
+#ifndef ASM_KERNEL
+#ifdef __OSCAR64C__
+#define ASM_KERNEL 1
+#else
+#define ASM_KERNEL 0
+#endif
+#endif
+
+// Oscar64 splits a __striped array of pointers into lo and hi byte tables
+#ifndef __OSCAR64C__
+#define __striped
+#endif
+
+// Cell buffers (swapped via pointers)
+static unsigned char buf0[BHEIGHT * BWIDTH];
+static unsigned char buf1[BHEIGHT * BWIDTH];
+unsigned char *current = buf0;
+unsigned char *next    = buf1;
+
+// Row pointers for both cell buffers (rows of buf0, then of buf1) and row
+// offsets into a 40x25 frame, built by build_wrap_tables. A row is one
+// table fetch with y in a register, where IDX and (y - 1) * WIDTH are a
+// 16-bit multiply. cur_rows/next_rows select the half for current/next
+// and are swapped with them.
+static unsigned char * __striped cell_rows[2 * BHEIGHT];
+static unsigned int __striped frame_rows[BHEIGHT];
+static unsigned char cur_rows = 0, next_rows = BHEIGHT;
+
+#define CUR_ROW(y)      cell_rows[cur_rows + (y)]
+#define NEXT_ROW(y)     cell_rows[next_rows + (y)]
+#define FRAME_ROW(f, y) ((f) + frame_rows[y])      // y = 1..HEIGHT
+
+// The frame being built, set up by the display code (see life.h)
+unsigned char *back;
+
+// Cleared while calc_next_gen_engine_quiet runs: the cells advance, but
+// the engines build no chars and leave back alone
+static bool drawing = true;
+
+#ifndef __OSCAR64C__
+unsigned char universe_cells[UHEIGHT * UPWIDTH];
+unsigned char bitmap_cells[HHEIGHT * HPWIDTH];
+unsigned char history_cells[HISTORY_SIZE];
+#endif
+
+// --- Preset patterns ---
+static const signed char P_BLOCK[][2]   = { {0,0},{1,0},{0,1},{1,1} };
+static const signed char P_BLINKER[][2] = { {0,0},{1,0},{2,0} };
+static const signed char P_GLIDER[][2]  = { {1,0},{2,1},{0,2},{1,2},{2,2} };
+static const signed char P_GGUN[][2] =
+{
+    {0,4},{1,4},{0,5},{1,5},
+    {10,4},{10,5},{10,6},{11,3},{11,7},{12,2},{12,8},{13,2},{13,8},{14,5},{15,3},{15,7},{16,4},{16,5},{16,6},{17,5},
+    {20,2},{20,3},{20,4},{21,2},{21,3},{21,4},{22,1},{22,5},{24,0},{24,1},{24,5},{24,6},
+    {34,2},{34,3},{35,2},{35,3}
+};
+
+#define N_BLOCK   (sizeof(P_BLOCK)/sizeof(P_BLOCK[0]))
+#define N_BLINKER (sizeof(P_BLINKER)/sizeof(P_BLINKER[0]))
+#define N_GLIDER  (sizeof(P_GLIDER)/sizeof(P_GLIDER[0]))
+#define N_GGUN    (sizeof(P_GGUN)/sizeof(P_GGUN[0]))
+
+// Branch-free rule table, indexed by alive * 9 + neighbours
+// (This is very cool, and I cannot take credit for this innovation)
+// Compiled from a B/S rule string by compile_rule, B3/S23 by default.
+static unsigned char rule_table[18];
+
+// Specialised copies for the asm kernel, indexed by neighbours * 2 + alive,
+// giving the next state and the matching screen char without a branch
+static unsigned char rule_pair[18];
+static unsigned char char_pair[18];
+
+// Bit-sliced form for the packed engine: one term per total t (neighbours
+// including the cell itself) that can give a live cell. A term matches
+// where the 1s/2s/4s/8s planes equal t (term_m* is $FF for each set bit of
+// t), and applies to dead cells (birth) and/or live cells (survival).
+#define MAX_RULE_TERMS 10
+static unsigned char term_count;
+static unsigned char term_m1[MAX_RULE_TERMS], term_m2[MAX_RULE_TERMS];
+static unsigned char term_m4[MAX_RULE_TERMS], term_m8[MAX_RULE_TERMS];
+static unsigned char term_dead[MAX_RULE_TERMS], term_alive[MAX_RULE_TERMS];
+
+// B3/S23 itself skips the terms: the packed engines use a fixed expression
+static bool rule_is_life;
+
+// Normalised rule string for the menu, e.g. "B36/S23"
+char rule_name[24];
+
+// Compile a rule string such as B3/S23 (Life), B36/S23 (HighLife),
+// B3678/S34678 (Day & Night) or B2/S (Seeds) into the tables above.
+// Returns RULE_OK, or why not and keeps the old rule: the string is
+// malformed, or it uses B0 (empty space would have to flip, which the
+// change-list engine cannot see).
+unsigned char compile_rule(const char *str)
+{
+    unsigned int born = 0, survive = 0;
+    unsigned int *digits = NULL;
+    bool has_b = false, has_s = false;
+
+    for (const char *p = str; *p; ++p)
+    {
+        char c = *p;
+        if ((c == 'b' || c == 'B') && !has_b)
+        {
+            has_b = true;
+            digits = &born;
+        }
+        else if ((c == 's' || c == 'S') && !has_s)
+        {
+            has_s = true;
+            digits = &survive;
+        }
+        else if (c >= '0' && c <= '8' && digits)
+            *digits |= 1 << (c - '0');
+        else if (c != '/' && c != ' ')
+            return RULE_BAD_SYNTAX;
+    }
+
+    if (!has_b || !has_s)
+        return RULE_BAD_SYNTAX;
+    if (born & 1)
+        return RULE_BAD_B0;
+
+    rule_is_life = born == (1 << 3) && survive == ((1 << 2) | (1 << 3));
+
+    term_count = 0;
+    for (unsigned char n = 0; n < 9; ++n)
+    {
+        unsigned char b = (unsigned char)((born >> n) & 1);
+        unsigned char a = (unsigned char)((survive >> n) & 1);
+
+        rule_table[n]        = b;
+        rule_table[9 + n]    = a;
+        rule_pair[2 * n]     = b;
+        rule_pair[2 * n + 1] = a;
+        char_pair[2 * n]     = b ? LIVE_CHAR : DEAD_CHAR;
+        char_pair[2 * n + 1] = a ? LIVE_CHAR : DEAD_CHAR;
+    }
+
+    // Total t is n for a dead cell and n + 1 for a live one
+    for (unsigned char t = 0; t <= 9; ++t)
+    {
+        unsigned char dead  = (t <= 8 && ((born >> t) & 1)) ? 0xFF : 0x00;
+        unsigned char alive = (t >= 1 && ((survive >> (t - 1)) & 1)) ? 0xFF : 0x00;
+        if (dead | alive)
+        {
+            term_m1[term_count]    = (t & 1) ? 0xFF : 0x00;
+            term_m2[term_count]    = (t & 2) ? 0xFF : 0x00;
+            term_m4[term_count]    = (t & 4) ? 0xFF : 0x00;
+            term_m8[term_count]    = (t & 8) ? 0xFF : 0x00;
+            term_dead[term_count]  = dead;
+            term_alive[term_count] = alive;
+            term_count++;
+        }
+    }
+
+    char *q = rule_name;
+    *q++ = 'B';
+    for (unsigned char n = 0; n < 9; ++n)
+        if ((born >> n) & 1) *q++ = (char)('0' + n);
+    *q++ = '/';
+    *q++ = 'S';
+    for (unsigned char n = 0; n < 9; ++n)
+        if ((survive >> n) & 1) *q++ = (char)('0' + n);
+    *q = 0;
+
+    return RULE_OK;
+}
+
+// Copy horizontal and vertical borders to make the wrapping logic simpler
+void update_borders(void)
+{
+    // Horizontal wrap: fix left/right border cells for each inner row.
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        unsigned char *row = CUR_ROW(y);
+        row[0] = row[WIDTH];        // left border <= right edge
+        row[BWIDTH - 1] = row[1];   // right border <= left edge
+    }
+
+    // Vertical wrap: copy whole rows in one go (includes the updated borders).
+    memcpy(CUR_ROW(0),           CUR_ROW(HEIGHT), BWIDTH);          // top border row
+    memcpy(CUR_ROW(BHEIGHT - 1), CUR_ROW(1),      BWIDTH);          // bottom border row
+}
+
+// --- Generation history ---
+// The byte-grid engines list the columns that changed in each row as they
+// compute it, and the lists go straight into a byte ring at HISTORY. A gen
+// is a run of rows (y, n, x1..xn), a 0, then its length in two bytes so the
+// ring can be walked backwards. A change is a toggle, so the same record
+// steps a gen back or forward. The oldest gens are dropped to make room.
+static unsigned char row_changes[WIDTH];        // columns changed in the row just computed
+
+static unsigned int hist_head;          // where the next byte goes
+static unsigned int hist_tail;          // start of the oldest gen
+static unsigned int hist_start;         // start of the gen being written
+static unsigned int hist_count;         // complete gens in the ring
+static unsigned int hist_cursor;        // end of the next gen to step back over
+static unsigned int hist_undone;        // gens stepped back
+
+static inline unsigned int hist_next(unsigned int i)
+{
+    return (i == HISTORY_SIZE - 1) ? 0 : i + 1;
+}
+
+static inline unsigned int hist_prev(unsigned int i, unsigned int d)
+{
+    return (i >= d) ? i - d : i + HISTORY_SIZE - d;
+}
+
+// Past a gen's 0 and its length
+static inline unsigned int hist_past_end(unsigned int i)
+{
+    i += 3;
+    return (i >= HISTORY_SIZE) ? i - HISTORY_SIZE : i;
+}
+
+// Start of the gen after the one at i
+static unsigned int hist_skip(unsigned int i)
+{
+    unsigned char y;
+    while ((y = HISTORY[i]) != 0)
+    {
+        i = hist_next(i);
+        unsigned char n = HISTORY[i];
+        for (unsigned char k = 0; k <= n; ++k)
+            i = hist_next(i);
+    }
+    return hist_past_end(i);
+}
+
+static void hist_put(unsigned char b)
+{
+    HISTORY[hist_head] = b;
+    hist_head = hist_next(hist_head);
+
+    // Full: the oldest gen goes
+    if (hist_head == hist_tail)
+    {
+        hist_tail = hist_skip(hist_tail);
+        hist_count--;
+    }
+}
+
+static void history_reset(void)
+{
+    hist_head = hist_tail = hist_cursor = 0;
+    hist_count = hist_undone = 0;
+}
+
+static inline void history_begin(void)
+{
+    hist_start = hist_head;
+}
+
+// Row y changed in the n columns listed in row_changes
+static void history_row(unsigned char y, unsigned char n)
+{
+    hist_put(y);
+    hist_put(n);
+    for (unsigned char k = 0; k < n; ++k)
+        hist_put(row_changes[k]);
+}
+
+static void history_end(void)
+{
+    hist_put(0);
+
+    unsigned int len = hist_head >= hist_start ? hist_head - hist_start : hist_head + HISTORY_SIZE - hist_start;
+    hist_put((unsigned char)len);
+    hist_put((unsigned char)(len >> 8));
+
+    hist_count++;
+    hist_cursor = hist_head;
+}
+
+// Toggle the cells of the gen starting at i, and their chars in dst
+static unsigned int hist_apply(unsigned int i, unsigned char *dst)
+{
+    unsigned char y;
+    while ((y = HISTORY[i]) != 0)
+    {
+        i = hist_next(i);
+        unsigned char n = HISTORY[i];
+        unsigned char *row = CUR_ROW(y);
+        unsigned char *s = FRAME_ROW(dst, y) - 1;
+
+        for (unsigned char k = 0; k < n; ++k)
+        {
+            i = hist_next(i);
+            unsigned char x = HISTORY[i];
+            unsigned char v = row[x] ^ 1;
+            row[x] = v;
+            s[x] = v ? LIVE_CHAR : DEAD_CHAR;
+        }
+        i = hist_next(i);
+    }
+    return hist_past_end(i);
+}
+
+bool history_back(unsigned char *dst)
+{
+    if (hist_undone == hist_count)
+        return false;
+
+    unsigned int len = HISTORY[hist_prev(hist_cursor, 2)] | (HISTORY[hist_prev(hist_cursor, 1)] << 8);
+    hist_cursor = hist_prev(hist_cursor, len + 2);
+    hist_apply(hist_cursor, dst);
+    hist_undone++;
+    return true;
+}
+
+bool history_forward(unsigned char *dst)
+{
+    if (!hist_undone)
+        return false;
+
+    hist_cursor = hist_apply(hist_cursor, dst);
+    hist_undone--;
+    return true;
+}
+
+// Redraw in dst just the cells the last gen changed, from its record: a
+// frame that showed the gen before needs no other writes
+void history_draw_last(unsigned char *dst)
+{
+    unsigned int i = hist_start;
+    unsigned char y;
+    while ((y = HISTORY[i]) != 0)
+    {
+        i = hist_next(i);
+        unsigned char n = HISTORY[i];
+        const unsigned char *row = CUR_ROW(y);
+        unsigned char *s = FRAME_ROW(dst, y) - 1;
+
+        for (unsigned char k = 0; k < n; ++k)
+        {
+            i = hist_next(i);
+            unsigned char x = HISTORY[i];
+            s[x] = row[x] ? LIVE_CHAR : DEAD_CHAR;
+        }
+        i = hist_next(i);
+    }
+}
+
+// --- Cell ages ---
+// For the heat map each byte-grid cell counts the gens it has been alive,
+// up to AGE_MAX, and its colour follows the age's bucket. Only the rows the
+// last gen changed (from its history record) or that still hold a cell
+// growing older are visited, and a colour is only written when a cell
+// moves to another bucket; dead cells are blank, so theirs is left alone.
+static unsigned char age_cells[HEIGHT * WIDTH];     // frame layout, 0 = dead
+static unsigned char age_colour[AGE_MAX + 1];
+static bool row_aging[BHEIGHT];
+
+void ages_start(unsigned char *col, const unsigned char *colours)
+{
+    for (unsigned char a = 0; a <= AGE_MAX; ++a)
+    {
+        unsigned char b = AGE_NEWBORN;
+        if (a >= AGE_MAX)
+            b = AGE_LONG;
+        else if (a >= AGE_OLD_FROM)
+            b = AGE_OLD;
+        else if (a >= AGE_YOUNG_FROM)
+            b = AGE_YOUNG;
+        age_colour[a] = colours[b];
+    }
+
+    // Whatever is alive now counts as just born
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        const unsigned char *row = CUR_ROW(y);
+        unsigned char *age = FRAME_ROW(age_cells, y) - 1;
+        unsigned char *c = FRAME_ROW(col, y) - 1;
+
+        for (unsigned char x = 1; x <= WIDTH; ++x)
+        {
+            age[x] = row[x];
+            c[x] = age_colour[1];
+        }
+        row_aging[y] = true;
+    }
+}
+
+void ages_update(unsigned char *col)
+{
+    unsigned int i = hist_start;
+    unsigned char y;
+    while ((y = HISTORY[i]) != 0)
+    {
+        row_aging[y] = true;
+        i = hist_next(i);
+        unsigned char n = HISTORY[i];
+        for (unsigned char k = 0; k <= n; ++k)
+            i = hist_next(i);
+    }
+
+    for (y = 1; y <= HEIGHT; ++y)
+    {
+        if (!row_aging[y])
+            continue;
+
+        const unsigned char *row = CUR_ROW(y);
+        unsigned char *age = FRAME_ROW(age_cells, y) - 1;
+        unsigned char *c = FRAME_ROW(col, y) - 1;
+        bool aging = false;
+
+        for (unsigned char x = 1; x <= WIDTH; ++x)
+        {
+            unsigned char a = age[x];
+            if (row[x])
+            {
+                if (a < AGE_MAX)
+                {
+                    age[x] = ++a;
+                    if (a == 1 || age_colour[a] != age_colour[a - 1])
+                        c[x] = age_colour[a];
+                    aging = true;
+                }
+            }
+            else if (a)
+                age[x] = 0;
+        }
+        row_aging[y] = aging;
+    }
+}
+
+// Per-row changed flags from the last gen, for rows 1..HEIGHT. Entries 0 and
+// HEIGHT + 1 mirror rows HEIGHT and 1 so the wrap needs no special case.
+static unsigned char row_dirty[BHEIGHT];
+
+#if ASM_KERNEL
+// Row pointers for the asm kernel, kept in zero page for (zp),y addressing
+static __zeropage unsigned char *zp_above;
+static __zeropage unsigned char *zp_row;
+static __zeropage unsigned char *zp_below;
+static __zeropage unsigned char *zp_out;
+static __zeropage unsigned char *zp_scr;     // screen row - 1, so it is indexed by x too
+static __zeropage unsigned char zp_diff;     // columns changed in the row, listed in row_changes
+
+// One row of calc_next_gen, x = 1..WIDTH in Y: nine (zp),y loads/adds, then
+// (neighbours * 2 + alive) indexes the specialised rule and char tables. A
+// changed cell also appends x to row_changes for the history. All sums stay
+// below 16, so carry is only cleared once. Measured on the tools/cpu6502
+// core (JSR to RTS, B3/S23 soup): 90 cycles a cell plus 14 per changed
+// cell; before the change list it was 81.5.
+static void calc_row_asm(void)
+{
+    __asm
+    {
+        ldy #0
+        sty zp_diff
+        clc
+    l1:
+        lda (zp_above), y       // x - 1
+        adc (zp_row), y
+        adc (zp_below), y
+        iny                     // x
+        adc (zp_above), y
+        adc (zp_below), y
+        iny                     // x + 1
+        adc (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        dey                     // back to x
+        asl
+        ora (zp_row), y
+        tax
+        lda char_pair, x
+        sta (zp_scr), y
+        lda rule_pair, x
+        sta (zp_out), y
+        eor (zp_row), y
+        beq l2
+        ldx zp_diff
+        tya
+        sta row_changes, x
+        inc zp_diff
+    l2:
+        cpy #WIDTH
+        bne l1
+    }
+}
+
+// The same without the chars, for gens that are not shown (measured 10
+// cycles a cell less: 80 plus 14 per changed cell)
+static void calc_row_asm_quiet(void)
+{
+    __asm
+    {
+        ldy #0
+        sty zp_diff
+        clc
+    l1:
+        lda (zp_above), y       // x - 1
+        adc (zp_row), y
+        adc (zp_below), y
+        iny                     // x
+        adc (zp_above), y
+        adc (zp_below), y
+        iny                     // x + 1
+        adc (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        dey                     // back to x
+        asl
+        ora (zp_row), y
+        tax
+        lda rule_pair, x
+        sta (zp_out), y
+        eor (zp_row), y
+        beq l2
+        ldx zp_diff
+        tya
+        sta row_changes, x
+        inc zp_diff
+    l2:
+        cpy #WIDTH
+        bne l1
+    }
+}
+
+// Both for the edge engine, which has no halo: x = 1 and x = WIDTH read
+// the opposite column, entering the shared tail from their own sums. The
+// inner cells cost what they do in the kernels above; the compare after
+// each cell also picks out x = WIDTH - 1 (carry set) to run the last one.
+static void calc_row_asm_edge(void)
+{
+    __asm
+    {
+        ldy #0
+        sty zp_diff
+        clc
+        ldy #WIDTH              // x = 1: x - 1 is the last column
+        lda (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        ldy #1
+        adc (zp_above), y
+        adc (zp_below), y
+        iny
+        adc (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        dey
+        jmp l2
+    l1:
+        lda (zp_above), y       // x - 1
+        adc (zp_row), y
+        adc (zp_below), y
+        iny                     // x
+        adc (zp_above), y
+        adc (zp_below), y
+        iny                     // x + 1
+        adc (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        dey                     // back to x
+    l2:
+        asl
+        ora (zp_row), y
+        tax
+        lda char_pair, x
+        sta (zp_scr), y
+        lda rule_pair, x
+        sta (zp_out), y
+        eor (zp_row), y
+        beq l3
+        ldx zp_diff
+        tya
+        sta row_changes, x
+        inc zp_diff
+    l3:
+        cpy #WIDTH - 1
+        bcc l1
+        bne l4
+        clc                     // x = WIDTH: x + 1 is the first column
+        ldy #1
+        lda (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        ldy #WIDTH - 1
+        adc (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        iny
+        adc (zp_above), y
+        adc (zp_below), y
+        jmp l2
+    l4:
+    }
+}
+
+static void calc_row_asm_edge_quiet(void)
+{
+    __asm
+    {
+        ldy #0
+        sty zp_diff
+        clc
+        ldy #WIDTH              // x = 1: x - 1 is the last column
+        lda (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        ldy #1
+        adc (zp_above), y
+        adc (zp_below), y
+        iny
+        adc (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        dey
+        jmp l2
+    l1:
+        lda (zp_above), y       // x - 1
+        adc (zp_row), y
+        adc (zp_below), y
+        iny                     // x
+        adc (zp_above), y
+        adc (zp_below), y
+        iny                     // x + 1
+        adc (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        dey                     // back to x
+    l2:
+        asl
+        ora (zp_row), y
+        tax
+        lda rule_pair, x
+        sta (zp_out), y
+        eor (zp_row), y
+        beq l3
+        ldx zp_diff
+        tya
+        sta row_changes, x
+        inc zp_diff
+    l3:
+        cpy #WIDTH - 1
+        bcc l1
+        bne l4
+        clc                     // x = WIDTH: x + 1 is the first column
+        ldy #1
+        lda (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        ldy #WIDTH - 1
+        adc (zp_above), y
+        adc (zp_row), y
+        adc (zp_below), y
+        iny
+        adc (zp_above), y
+        adc (zp_below), y
+        jmp l2
+    l4:
+    }
+}
+#endif
+
+// Calculate row y of the next gen into out from the rows above, at and
+// below it, build its chars in back, and record its changes. Returns
+// non-zero if any cell in the row changed.
+static unsigned char calc_row_from(unsigned char y, unsigned char *row_above, unsigned char *row, unsigned char *row_below, unsigned char *out)
+{
+    unsigned char *s = FRAME_ROW(back, y);
+
+    unsigned char changed = 0;
+
+#if ASM_KERNEL
+    zp_above = row_above;
+    zp_row   = row;
+    zp_below = row_below;
+    zp_out   = out;
+    zp_scr   = s - 1;
+    if (drawing)
+        calc_row_asm();
+    else
+        calc_row_asm_quiet();
+    changed = zp_diff;
+#else
+    for (unsigned char x = 1; x <= WIDTH; ++x)
+    {
+        unsigned char neighbours =
+            row_above[x - 1] +
+            row_above[x] +
+            row_above[x + 1] +
+            row[x - 1] +
+            row[x + 1] +
+            row_below[x - 1] +
+            row_below[x] +
+            row_below[x + 1];
+
+        unsigned char alive = row[x];
+        unsigned char v = rule_table[alive * 9 + neighbours];
+
+        out[x] = v;
+        if (drawing)
+            s[x - 1] = v ? LIVE_CHAR : DEAD_CHAR;
+        if (v != alive)
+            row_changes[changed++] = x;
+    }
+#endif
+
+    if (changed)
+        history_row(y, changed);
+    return changed;
+}
+
+static inline unsigned char calc_row(unsigned char y)
+{
+    return calc_row_from(y, CUR_ROW(y - 1), CUR_ROW(y), CUR_ROW(y + 1), NEXT_ROW(y));
+}
+
+static void mirror_row_dirty(void)
+{
+    row_dirty[0] = row_dirty[HEIGHT];
+    row_dirty[HEIGHT + 1] = row_dirty[1];
+}
+
+// Calculate the next gen, and build the NEXT frame's characters in back
+void calc_next_gen(void)
+{
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+        row_dirty[y] = calc_row(y);
+
+    mirror_row_dirty();
+}
+
+// Like calc_next_gen, but skips rows whose neighbourhood (rows y-1..y+1)
+// did not change in the last gen. Such a row is already correct in both
+// next and back: they hold the previous gen, and that row has not changed.
+void calc_next_gen_dirty(void)
+{
+    unsigned char above = row_dirty[0];
+
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        unsigned char here = row_dirty[y];
+        unsigned char v = 0;
+
+        if (above | here | row_dirty[y + 1])
+            v = calc_row(y);
+
+        above = here;
+        row_dirty[y] = v;
+    }
+
+    mirror_row_dirty();
+}
+
+// One cell whose left/right neighbours are in columns xl/xr (for the wrap)
+static inline unsigned char edge_cell(const unsigned char *above, const unsigned char *row, const unsigned char *below,
+                                      unsigned char xl, unsigned char x, unsigned char xr)
+{
+    unsigned char neighbours =
+        above[xl] + above[x] + above[xr] +
+        row[xl] + row[xr] +
+        below[xl] + below[x] + below[xr];
+
+    return rule_table[row[x] * 9 + neighbours];
+}
+
+// Row y of the next gen without the halo: the first and last columns read
+// the opposite column directly. Like calc_row_from, it builds the row's
+// chars in back, records its changes and returns how many cells changed.
+static unsigned char calc_row_edge(unsigned char y, unsigned char *row_above, unsigned char *row, unsigned char *row_below, unsigned char *out)
+{
+    unsigned char *s = FRAME_ROW(back, y);
+    unsigned char n = 0;
+
+#if ASM_KERNEL
+    zp_above = row_above;
+    zp_row   = row;
+    zp_below = row_below;
+    zp_out   = out;
+    zp_scr   = s - 1;
+    if (drawing)
+        calc_row_asm_edge();
+    else
+        calc_row_asm_edge_quiet();
+    n = zp_diff;
+#else
+    unsigned char v;
+
+    // First column: left neighbour is the last column
+    v = edge_cell(row_above, row, row_below, WIDTH, 1, 2);
+    out[1] = v;
+    if (drawing)
+        s[0] = v ? LIVE_CHAR : DEAD_CHAR;
+    if (v != row[1])
+        row_changes[n++] = 1;
+
+    for (unsigned char x = 2; x < WIDTH; ++x)
+    {
+        unsigned char neighbours =
+            row_above[x - 1] +
+            row_above[x] +
+            row_above[x + 1] +
+            row[x - 1] +
+            row[x + 1] +
+            row_below[x - 1] +
+            row_below[x] +
+            row_below[x + 1];
+
+        v = rule_table[row[x] * 9 + neighbours];
+        out[x] = v;
+        if (drawing)
+            s[x - 1] = v ? LIVE_CHAR : DEAD_CHAR;
+        if (v != row[x])
+            row_changes[n++] = x;
+    }
+
+    // Last column: right neighbour is the first column
+    v = edge_cell(row_above, row, row_below, WIDTH - 1, WIDTH, 1);
+    out[WIDTH] = v;
+    if (drawing)
+        s[WIDTH - 1] = v ? LIVE_CHAR : DEAD_CHAR;
+    if (v != row[WIDTH])
+        row_changes[n++] = WIDTH;
+#endif
+
+    if (n)
+        history_row(y, n);
+    return n;
+}
+
+// Next gen without the halo: the first and last rows take the opposite row
+// as their neighbour and calc_row_edge wraps the columns, so no update_borders
+void calc_next_gen_edge(void)
+{
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+        row_dirty[y] = calc_row_edge(y, CUR_ROW((y == 1) ? HEIGHT : y - 1), CUR_ROW(y), CUR_ROW((y == HEIGHT) ? 1 : y + 1), NEXT_ROW(y));
+
+    mirror_row_dirty();
+}
+
+// Columns of the row before the one just calculated whose cells still have
+// to be toggled, for calc_next_gen_inplace
+static unsigned char row_flips[WIDTH];
+static unsigned char n_flips;
+
+#if ASM_KERNEL
+// Toggle the n_flips cells of row zp_out listed in row_flips, then keep the
+// zp_diff columns in row_changes as the next row's. 24 cycles a toggle
+// plus 16 a column kept.
+static void flip_row_asm(void)
+{
+    __asm
+    {
+        ldx n_flips
+        beq l2
+    l1:
+        dex
+        ldy row_flips, x
+        lda (zp_out), y
+        eor #1
+        sta (zp_out), y
+        txa
+        bne l1
+    l2:
+        ldx zp_diff
+        stx n_flips
+        beq l4
+    l3:
+        dex
+        lda row_changes, x
+        sta row_flips, x
+        txa
+        bne l3
+    l4:
+    }
+}
+#endif
+
+// Apply the pending toggles to row, and queue the n in row_changes
+static void flip_row(unsigned char *row, unsigned char n)
+{
+#if ASM_KERNEL
+    zp_out  = row;
+    zp_diff = n;
+    flip_row_asm();
+#else
+    for (unsigned char k = 0; k < n_flips; ++k)
+        row[row_flips[k]] ^= 1;
+    for (n_flips = 0; n_flips < n; ++n_flips)
+        row_flips[n_flips] = row_changes[n_flips];
+#endif
+}
+
+// Like calc_next_gen_edge, but over current alone: each row's changes are
+// toggled in a row late, and the last row wraps to a saved copy of row 1
+static unsigned char inplace_first[BWIDTH], inplace_sink[BWIDTH];
+
+void calc_next_gen_inplace(void)
+{
+    unsigned char *above = CUR_ROW(HEIGHT);
+
+    memcpy(inplace_first, CUR_ROW(1), BWIDTH);
+    n_flips = 0;
+
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        unsigned char *row = CUR_ROW(y);
+        unsigned char n = calc_row_edge(y, above, row, (y == HEIGHT) ? inplace_first : CUR_ROW(y + 1), inplace_sink);
+
+        flip_row(above, n);         // row y - 1; nothing is pending at y = 1
+        row_dirty[y] = n;
+        above = row;
+    }
+    flip_row(above, 0);
+
+    mirror_row_dirty();
+}
+
+// Vertical 3-cell sums for every column (incl. borders) of the row being computed
+static unsigned char colsum[BWIDTH];
+
+// Separable version of calc_next_gen: sum each column once, then slide a
+// 3-column window along the row. Per cell that is one new column sum plus
+// one add and one subtract, instead of eight loads and seven adds.
+// It is plain C, while on the C64 the naive engine runs the asm kernel, so
+// compare the two there with a PRG built with -dASM_KERNEL=0 ("make -C
+// tools cycles-c"); the default build's figures are C against asm.
+void calc_next_gen_separable(void)
+{
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        unsigned char *row_above = CUR_ROW(y - 1);
+        unsigned char *row       = CUR_ROW(y);
+        unsigned char *row_below = CUR_ROW(y + 1);
+        unsigned char *out       = NEXT_ROW(y);
+        unsigned char *s         = FRAME_ROW(back, y);
+
+        for (unsigned char x = 0; x < BWIDTH; ++x)
+            colsum[x] = row_above[x] + row[x] + row_below[x];
+
+        // Window holds colsum[x-1] + colsum[x] + colsum[x+1] (includes the cell itself)
+        unsigned char window = colsum[0] + colsum[1];
+        unsigned char n = 0;
+
+        for (unsigned char x = 1; x <= WIDTH; ++x)
+        {
+            window += colsum[x + 1];
+
+            // alive * 9 + (window - alive): the window already counts the cell
+            unsigned char alive = row[x];
+            unsigned char v = rule_table[alive * 8 + window];
+
+            out[x] = v;
+            if (drawing)
+                s[x - 1] = v ? LIVE_CHAR : DEAD_CHAR;
+            if (v != alive)
+                row_changes[n++] = x;
+
+            window -= colsum[x - 1];
+        }
+
+        if (n)
+            history_row(y, n);
+        row_dirty[y] = n;
+    }
+
+    mirror_row_dirty();
+}
+
+// --- Bit-packed universes: 1 bit per cell, 8 cells per byte ---
+// MSB is the leftmost cell. A byte holds 8 cells so all the neighbour
+// counting below is done with bit-sliced adders, 8 cells per operation.
+// The same kernel runs the packed 40x25 grid, the large universe and the
+// hi-res bitmap, whose rows step 8 bytes from one byte to the next.
+#define PWIDTH (WIDTH / 8)
+
+static unsigned char packed[HEIGHT * PWIDTH];
+
+// The 128x128 universe (2K at UNIVERSE) and the hi-res bitmap are the
+// largest, see life.h
+#define MAX_PWIDTH  HPWIDTH
+#define MAX_PHEIGHT HHEIGHT
+
+// Geometry of the packed universe the kernel is working on
+static unsigned char *pack_rows[MAX_PHEIGHT];
+static unsigned char pack_pw, pack_ph;     // bytes per row, rows
+static unsigned char pack_stride;          // distance between bytes of a row
+static unsigned int  pack_last;            // offset of the last byte of a row
+
+static const unsigned char bit_mask[8] = {0x80,0x40,0x20,0x10,0x08,0x04,0x02,0x01};
+
+// Horizontal 3-cell sums (left + self + right) of a packed row, as two bit
+// planes: sum = lo + 2*hi. Ring of 3 rows plus the saved first row for the wrap.
+static unsigned char hsum_lo[4][MAX_PWIDTH];
+static unsigned char hsum_hi[4][MAX_PWIDTH];
+
+static void pack_setup(unsigned char *base, unsigned char pw, unsigned char ph)
+{
+    pack_pw = pw;
+    pack_ph = ph;
+    pack_stride = 1;
+    pack_last = pw - 1;
+    for (unsigned char y = 0; y < ph; ++y, base += pw)
+        pack_rows[y] = base;
+}
+
+static void pack_setup_bitmap(void)
+{
+    pack_pw = HPWIDTH;
+    pack_ph = HHEIGHT;
+    pack_stride = 8;
+    pack_last = (HPWIDTH - 1) * 8;
+    for (unsigned char y = 0; y < HHEIGHT; ++y)
+        pack_rows[y] = BITMAP + (y >> 3) * HWIDTH + (y & 7);
+}
+
+// Byte i of a packed row
+static inline unsigned char *pack_byte(unsigned char *row, unsigned char i)
+{
+    return row + (unsigned int)i * pack_stride;
+}
+
+// Full adder across each packed byte of a row and its two shifted copies
+static void pack_hsum(const unsigned char *row, unsigned char *lo, unsigned char *hi)
+{
+    unsigned char last = pack_pw - 1;
+    unsigned char prev = row[pack_last];    // horizontal wrap
+    unsigned char c = row[0];
+    const unsigned char *p = row;
+
+    for (unsigned char i = 0; i <= last; ++i)
+    {
+        p += pack_stride;
+        unsigned char r = (i < last) ? *p : row[0];
+        unsigned char left  = (unsigned char)((c >> 1) | (prev << 7));
+        unsigned char right = (unsigned char)((c << 1) | (r >> 7));
+        unsigned char t = left ^ right;
+
+        lo[i] = t ^ c;
+        hi[i] = (left & right) | (t & c);
+
+        prev = c;
+        c = r;
+    }
+}
+
+// Add the horizontal sums of three rows with bit-sliced full/half adders
+// into 1s/2s/4s/8s planes of the total t (0..9, including the cell itself),
+// then apply the rule. B3/S23 (t == 3 for any cell, t == 4 for a live one)
+// is a fixed expression; other rules OR their compiled terms, which costs
+// about one B3/S23 per two terms.
+static void pack_rule(unsigned char a, unsigned char b, unsigned char c, unsigned char *row)
+{
+    for (unsigned char i = 0; i < pack_pw; ++i, row += pack_stride)
+    {
+        unsigned char a0 = hsum_lo[a][i], b0 = hsum_lo[b][i], c0 = hsum_lo[c][i];
+        unsigned char a1 = hsum_hi[a][i], b1 = hsum_hi[b][i], c1 = hsum_hi[c][i];
+
+        unsigned char x  = a0 ^ b0;
+        unsigned char t1 = x ^ c0;                          // 1s
+        unsigned char k1 = (a0 & b0) | (x & c0);            // carry into 2s
+        unsigned char y  = a1 ^ b1;
+        unsigned char u  = y ^ c1;                          // 2s from the hi planes
+        unsigned char k2 = (a1 & b1) | (y & c1);            // carry into 4s
+        unsigned char k3 = k1 & u;                          // carry into 4s
+        unsigned char t2 = k1 ^ u;                          // 2s
+        unsigned char t4 = k2 ^ k3;                         // 4s
+        unsigned char t8 = k2 & k3;                         // 8s
+
+        unsigned char alive = *row;
+        unsigned char v = 0;
+
+        if (rule_is_life)
+            v = (unsigned char)((t1 & t2 & ~t4) | (alive & ~t1 & ~t2 & t4));
+        else
+        {
+            for (unsigned char k = 0; k < term_count; ++k)
+            {
+                unsigned char miss = (t1 ^ term_m1[k]) | (t2 ^ term_m2[k]) | (t4 ^ term_m4[k]) | (t8 ^ term_m8[k]);
+                v |= (unsigned char)(~miss & ((alive & term_alive[k]) | (~alive & term_dead[k])));
+            }
+        }
+
+        *row = v;
+    }
+}
+
+// Next gen of the packed universe, updated in place: the horizontal sums of
+// row y+1 are taken before row y is overwritten, and row 0's sums are kept
+// for the bottom row's wrap.
+static void pack_generation(void)
+{
+    unsigned char a = 0, b = 1, c = 2;
+    unsigned char last = pack_ph - 1;
+
+    pack_hsum(pack_rows[last], hsum_lo[a], hsum_hi[a]);
+    pack_hsum(pack_rows[0], hsum_lo[b], hsum_hi[b]);
+    memcpy(hsum_lo[3], hsum_lo[b], pack_pw);
+    memcpy(hsum_hi[3], hsum_hi[b], pack_pw);
+
+    for (unsigned char y = 0; y <= last; ++y)
+    {
+        if (y < last)
+            pack_hsum(pack_rows[y + 1], hsum_lo[c], hsum_hi[c]);
+        else
+            c = 3;
+
+        pack_rule(a, b, c, pack_rows[y]);
+
+        unsigned char t = a;
+        a = b;
+        b = c;
+        c = t;
+    }
+}
+
+// Expand 8 packed cells into screen chars
+static void pack_byte_to_chars(unsigned char bits, unsigned char *s)
+{
+    for (unsigned char b = 0; b < 8; ++b)
+    {
+        s[b] = (bits & 0x80) ? LIVE_CHAR : DEAD_CHAR;
+        bits <<= 1;
+    }
+}
+
+// Expand 8 packed cells into a row of the byte grid
+static void pack_byte_to_cells(unsigned char bits, unsigned char *c)
+{
+    for (unsigned char b = 0; b < 8; ++b)
+    {
+        c[b] = bits >> 7;
+        bits <<= 1;
+    }
+}
+
+// Chars for the packed 40x25 grid
+static void packed_to_chars(unsigned char *s)
+{
+    for (unsigned char y = 0; y < HEIGHT; ++y)
+    {
+        const unsigned char *row = pack_rows[y];
+        for (unsigned char i = 0; i < PWIDTH; ++i, s += 8)
+            pack_byte_to_chars(row[i], s);
+    }
+}
+
+// Next gen of the packed 40x25 grid, then its chars in back
+void calc_next_gen_packed(void)
+{
+    pack_generation();
+    if (drawing)
+        packed_to_chars(back);
+}
+
+// Top-left cell of the viewport into the large universe
+unsigned char view_x, view_y;
+
+// Chars for just the 40x25 viewport of the large universe. The viewport
+// need not be byte aligned, so each screen byte is shifted together from
+// two neighbouring universe bytes (wrapping round the torus).
+static void universe_to_chars(unsigned char *s)
+{
+    unsigned char bx = view_x >> 3, sh = view_x & 7;
+
+    for (unsigned char r = 0; r < HEIGHT; ++r)
+    {
+        const unsigned char *row = pack_rows[(unsigned char)(view_y + r) & (UHEIGHT - 1)];
+        unsigned char cur = row[bx];
+
+        for (unsigned char k = 1; k <= PWIDTH; ++k, s += 8)
+        {
+            unsigned char nxt = row[(bx + k) & (UPWIDTH - 1)];
+            unsigned char bits = sh ? (unsigned char)((cur << sh) | (nxt >> (8 - sh))) : cur;
+            pack_byte_to_chars(bits, s);
+            cur = nxt;
+        }
+    }
+}
+
+// Next gen of the large universe, then chars for its viewport in back
+void calc_next_gen_universe(void)
+{
+    pack_generation();
+    if (drawing)
+        universe_to_chars(back);
+}
+
+// Convert between the byte-per-cell grid and the packed universe. The grid
+// goes in with its top-left at (oy,ox); the 40x25 window there comes back.
+static void pack_from_current(unsigned char oy, unsigned char ox)
+{
+    for (unsigned char y = 0; y < pack_ph; ++y)
+        for (unsigned char i = 0; i < pack_pw; ++i)
+            *pack_byte(pack_rows[y], i) = 0;
+
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        unsigned char *row = pack_rows[oy + y - 1];
+        const unsigned char *cells = CUR_ROW(y);
+        for (unsigned char x = 1; x <= WIDTH; ++x)
+        {
+            unsigned int px = ox + x - 1;
+            if (cells[x])
+                *pack_byte(row, (unsigned char)(px >> 3)) |= bit_mask[px & 7];
+        }
+    }
+}
+
+static void unpack_to_current(unsigned char oy, unsigned char ox)
+{
+    unsigned int cw = pack_pw * 8;
+
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        unsigned char *row = pack_rows[(oy + y - 1) % pack_ph];
+        unsigned char *cells = CUR_ROW(y);
+        for (unsigned char x = 1; x <= WIDTH; ++x)
+        {
+            unsigned int px = (ox + x - 1) % cw;
+            cells[x] = (*pack_byte(row, (unsigned char)(px >> 3)) & bit_mask[px & 7]) ? 1 : 0;
+        }
+    }
+}
+
+// --- Random soups ---
+// A 16-bit xorshift (7, 9, 8: shifts by 8 are byte moves on the 6502)
+// gives a byte, that is 8 cells, per step. Lower densities AND bytes
+// together: 1/8 = a & b & c, 2/8 = a & b, 3/8 = a & (b | c), 4/8 = a.
+// The state is uint16_t so a host build gives the same soups as the C64.
+static uint16_t rand_state = 1;
+unsigned char density = DENSITY_50;
+
+void random_seed(unsigned int seed)
+{
+    rand_state = seed ? seed : 0xACE1;      // 0 would stay 0
+}
+
+static unsigned char rand_byte(void)
+{
+    uint16_t x = rand_state;
+    x ^= x << 7;
+    x ^= x >> 9;
+    x ^= x << 8;
+    rand_state = x;
+    return (unsigned char)x;
+}
+
+// 8 random cells at the selected density, MSB first
+static unsigned char random_cells(void)
+{
+    unsigned char a = rand_byte();
+
+    switch (density)
+    {
+        case DENSITY_12: return a & rand_byte() & rand_byte();
+        case DENSITY_25: return a & rand_byte();
+        case DENSITY_37: return a & (rand_byte() | rand_byte());
+        default:         return a;
+    }
+}
+
+// Random fill of the whole packed universe
+static void pack_random(void)
+{
+    for (unsigned char y = 0; y < pack_ph; ++y)
+        for (unsigned char i = 0; i < pack_pw; ++i)
+            *pack_byte(pack_rows[y], i) = random_cells();
+}
+
+// --- 80x50 quad-cell mode: each char shows a 2x2 block of cells ---
+// Glyph g has bit 3 = top-left, 2 = top-right, 1 = bottom-left,
+// 0 = bottom-right, so a char is just 2 bits from each of two packed rows.
+static unsigned char quad[QHEIGHT * QPWIDTH];
+
+// Glyphs for the whole 80x50 universe: each pair of packed rows gives one
+// screen row, each byte pair gives 4 chars, with no per-cell branching
+static void quad_to_chars(unsigned char *s)
+{
+    for (unsigned char y = 0; y < QHEIGHT; y += 2)
+    {
+        const unsigned char *r0 = pack_rows[y];
+        const unsigned char *r1 = pack_rows[y + 1];
+
+        for (unsigned char i = 0; i < QPWIDTH; ++i, s += 4)
+        {
+            unsigned char t = r0[i], b = r1[i];
+            s[0] = (unsigned char)(((t >> 4) & 0x0C) | (b >> 6));
+            s[1] = (unsigned char)(((t >> 2) & 0x0C) | ((b >> 4) & 0x03));
+            s[2] = (unsigned char)((t & 0x0C) | ((b >> 2) & 0x03));
+            s[3] = (unsigned char)(((t << 2) & 0x0C) | (b & 0x03));
+        }
+    }
+}
+
+void calc_next_gen_quad(void)
+{
+    pack_generation();
+    if (drawing)
+        quad_to_chars(back);
+}
+
+// --- Change-list engine: only evaluate cells next to last gen's changes ---
+// A cell can only change if something in its 3x3 block changed in the last
+// gen, so each gen evaluates the neighbourhoods of the previous change list
+// and builds the next one. Works in place on current, keeping the halo
+// copies of edge cells up to date itself, so it needs no update_borders.
+#define MAX_CHANGES (WIDTH * HEIGHT)
+
+static unsigned char chg_y[2][MAX_CHANGES];
+static unsigned char chg_x[2][MAX_CHANGES];
+static int chg_count[2];
+static unsigned char chg_cur;           // list holding the last gen's changes
+
+// Candidates already evaluated this gen (1 bit per cell, rows of PWIDTH bytes);
+// then this gen's changes, with the rows they are in
+static unsigned char seen[HEIGHT * PWIDTH];
+static unsigned char chg_rows[BHEIGHT];
+
+// Wrapped neighbour coordinates, and the halo copy of each edge row/column
+static unsigned char x_left[BWIDTH], x_right[BWIDTH], x_halo[BWIDTH];
+static unsigned char y_up[BHEIGHT], y_down[BHEIGHT], y_halo[BHEIGHT];
+
+void build_wrap_tables(void)
+{
+    for (unsigned char x = 1; x <= WIDTH; ++x)
+    {
+        x_left[x]  = (x == 1) ? WIDTH : x - 1;
+        x_right[x] = (x == WIDTH) ? 1 : x + 1;
+        x_halo[x]  = (x == 1) ? WIDTH + 1 : (x == WIDTH) ? 0 : x;
+    }
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        y_up[y]   = (y == 1) ? HEIGHT : y - 1;
+        y_down[y] = (y == HEIGHT) ? 1 : y + 1;
+        y_halo[y] = (y == 1) ? HEIGHT + 1 : (y == HEIGHT) ? 0 : y;
+    }
+
+    // Row tables (see cell_rows)
+    for (unsigned char y = 0; y < BHEIGHT; ++y)
+    {
+        cell_rows[y] = buf0 + y * BWIDTH;
+        cell_rows[BHEIGHT + y] = buf1 + y * BWIDTH;
+    }
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+        frame_rows[y] = (y - 1) * WIDTH;
+    cur_rows = (current == buf0) ? 0 : BHEIGHT;
+    next_rows = BHEIGHT - cur_rows;
+}
+
+// Set a cell and its halo copies (edge cells have 1, corners 3)
+static void put_cell(unsigned char y, unsigned char x, unsigned char v)
+{
+    unsigned char hx = x_halo[x], hy = y_halo[y];
+
+    unsigned char *row = CUR_ROW(y);
+
+    row[x] = v;
+    if (hx != x)
+        row[hx] = v;
+    if (hy != y)
+    {
+        row = CUR_ROW(hy);
+        row[x] = v;
+        if (hx != x)
+            row[hx] = v;
+    }
+}
+
+// Evaluate one candidate cell once, and queue it if it changes
+static void consider_cell(unsigned char y, unsigned char x, unsigned char list)
+{
+    unsigned char *m = seen + (y - 1) * PWIDTH + ((x - 1) >> 3);
+    unsigned char bit = bit_mask[(x - 1) & 7];
+    if (*m & bit)
+        return;
+    *m |= bit;
+
+    const unsigned char *p = CUR_ROW(y) + x;
+    unsigned char neighbours =
+        p[-BWIDTH - 1] + p[-BWIDTH] + p[-BWIDTH + 1] +
+        p[-1] + p[1] +
+        p[BWIDTH - 1] + p[BWIDTH] + p[BWIDTH + 1];
+
+    unsigned char alive = *p;
+    unsigned char v = rule_table[alive * 9 + neighbours];
+
+    if (v != alive)
+    {
+        int n = chg_count[list]++;
+        chg_y[list][n] = y;
+        chg_x[list][n] = x;
+    }
+}
+
+// Redraw the listed cells in back from current
+static void draw_changes(unsigned char list)
+{
+    for (int i = 0; i < chg_count[list]; ++i)
+    {
+        unsigned char y = chg_y[list][i], x = chg_x[list][i];
+        FRAME_ROW(back, y)[x - 1] = CUR_ROW(y)[x] ? LIVE_CHAR : DEAD_CHAR;
+    }
+}
+
+// Seed the change list with every live cell (their blocks cover every cell
+// that can change) and bring the halo up to date once
+static void events_start(void)
+{
+    update_borders();
+    memset(seen, 0, sizeof(seen));
+
+    chg_cur = 0;
+    chg_count[0] = 0;
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        const unsigned char *row = CUR_ROW(y);
+        for (unsigned char x = 1; x <= WIDTH; ++x)
+        {
+            if (row[x])
+            {
+                int n = chg_count[0]++;
+                chg_y[0][n] = y;
+                chg_x[0][n] = x;
+            }
+        }
+    }
+}
+
+// Next gen from the change list. back holds the frame before last, so both
+// the last gen's and this gen's changes are redrawn into it.
+void calc_next_gen_events(void)
+{
+    unsigned char old = chg_cur, nxt = chg_cur ^ 1;
+    int n = chg_count[old];
+
+    chg_count[nxt] = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        unsigned char y = chg_y[old][i], x = chg_x[old][i];
+        unsigned char yu = y_up[y], yd = y_down[y];
+        unsigned char xl = x_left[x], xr = x_right[x];
+
+        consider_cell(yu, xl, nxt); consider_cell(yu, x, nxt); consider_cell(yu, xr, nxt);
+        consider_cell(y,  xl, nxt); consider_cell(y,  x, nxt); consider_cell(y,  xr, nxt);
+        consider_cell(yd, xl, nxt); consider_cell(yd, x, nxt); consider_cell(yd, xr, nxt);
+    }
+
+    // Clear just the seen bits that were set
+    for (int i = 0; i < n; ++i)
+    {
+        unsigned char y = chg_y[old][i], x = chg_x[old][i];
+        unsigned char yu = y_up[y], yd = y_down[y];
+        unsigned char xl = x_left[x], xr = x_right[x];
+        unsigned char bl = bit_mask[(xl - 1) & 7], bc = bit_mask[(x - 1) & 7], br = bit_mask[(xr - 1) & 7];
+        unsigned char il = (xl - 1) >> 3, ic = (x - 1) >> 3, ir = (xr - 1) >> 3;
+
+        unsigned char *m = seen + (yu - 1) * PWIDTH;
+        m[il] &= ~bl; m[ic] &= ~bc; m[ir] &= ~br;
+        m = seen + (y - 1) * PWIDTH;
+        m[il] &= ~bl; m[ic] &= ~bc; m[ir] &= ~br;
+        m = seen + (yd - 1) * PWIDTH;
+        m[il] &= ~bl; m[ic] &= ~bc; m[ir] &= ~br;
+    }
+
+    // Apply the changes, marking them in seen, then hand them to the
+    // history a row at a time (clearing seen again), as the other engines do
+    for (int i = 0; i < chg_count[nxt]; ++i)
+    {
+        unsigned char y = chg_y[nxt][i], x = chg_x[nxt][i];
+        put_cell(y, x, CUR_ROW(y)[x] ^ 1);
+        seen[(y - 1) * PWIDTH + ((x - 1) >> 3)] |= bit_mask[(x - 1) & 7];
+        chg_rows[y] = 1;
+    }
+
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        if (!chg_rows[y])
+            continue;
+        chg_rows[y] = 0;
+
+        unsigned char *m = seen + (y - 1) * PWIDTH;
+        unsigned char k = 0;
+        for (unsigned char i = 0; i < PWIDTH; ++i, ++m)
+        {
+            unsigned char b = *m;
+            if (!b)
+                continue;
+            *m = 0;
+            for (unsigned char x = i * 8 + 1; b; ++x, b <<= 1)
+                if (b & 0x80)
+                    row_changes[k++] = x;
+        }
+        if (k)
+            history_row(y, k);
+    }
+
+    if (drawing)
+    {
+        draw_changes(old);
+        draw_changes(nxt);
+    }
+    chg_cur = nxt;
+}
+
+static void swap_cells(void)
+{
+    unsigned char *tmp = current;
+    current = next;
+    next = tmp;
+
+    unsigned char t = cur_rows;
+    cur_rows = next_rows;
+    next_rows = t;
+}
+
+unsigned char engine = ENGINE_NAIVE;
+
+// Engines that read the 42x27 halo need update_borders before each gen
+bool engine_uses_borders(void)
+{
+    return engine == ENGINE_NAIVE || engine == ENGINE_SEPARABLE || engine == ENGINE_DIRTY;
+}
+
+// The 40x25 byte-grid engines record each gen's changes (see history_row)
+bool engine_keeps_history(void)
+{
+    return engine == ENGINE_NAIVE || engine == ENGINE_SEPARABLE || engine == ENGINE_DIRTY ||
+           engine == ENGINE_EVENTS || engine == ENGINE_EDGE || engine == ENGINE_INPLACE;
+}
+
+// Run on from the gen history_back stepped to: the gens after it are
+// dropped, and the engines' own state is rebuilt from current
+void history_resume(void)
+{
+    hist_head = hist_cursor;
+    hist_count -= hist_undone;
+    hist_undone = 0;
+
+    if (engine == ENGINE_EVENTS)
+        events_start();
+    memset(row_dirty, 1, BHEIGHT);
+}
+
+// Set by grid_random, so engines with a larger universe fill all of it
+static bool random_start;
+
+// Move the grid into/out of the engine's own storage format
+void engine_start(void)
+{
+    if (engine == ENGINE_BITPACK)
+    {
+        pack_setup(packed, PWIDTH, HEIGHT);
+        pack_from_current(0, 0);
+    }
+    else if (engine == ENGINE_EVENTS)
+        events_start();
+    else if (engine == ENGINE_UNIVERSE)
+    {
+        // The 40x25 grid goes in the middle, with the viewport on it
+        view_x = (UWIDTH - WIDTH) / 2;
+        view_y = (UHEIGHT - HEIGHT) / 2;
+        pack_setup(UNIVERSE, UPWIDTH, UHEIGHT);
+        pack_from_current(view_y, view_x);
+        if (random_start)
+            pack_random();
+    }
+    else if (engine == ENGINE_HIRES)
+    {
+        pack_setup_bitmap();
+        pack_from_current((HHEIGHT - HEIGHT) / 2, (HWIDTH - WIDTH) / 2);
+        if (random_start)
+            pack_random();
+    }
+    else if (engine == ENGINE_QUAD)
+    {
+        pack_setup(quad, QPWIDTH, QHEIGHT);
+        pack_from_current((QHEIGHT - HEIGHT) / 2, (QWIDTH - WIDTH) / 2);
+        if (random_start)
+            pack_random();
+    }
+
+    random_start = false;
+    history_reset();
+
+    // Nothing is known to be settled yet
+    memset(row_dirty, 1, BHEIGHT);
+}
+
+void engine_stop(void)
+{
+    if (engine == ENGINE_BITPACK)
+        unpack_to_current(0, 0);
+    else if (engine == ENGINE_UNIVERSE)
+        unpack_to_current(view_y, view_x);
+    else if (engine == ENGINE_HIRES)
+        unpack_to_current((HHEIGHT - HEIGHT) / 2, (HWIDTH - WIDTH) / 2);
+    else if (engine == ENGINE_QUAD)
+        unpack_to_current((QHEIGHT - HEIGHT) / 2, (QWIDTH - WIDTH) / 2);
+}
+
+// Build the chars of the engine's current state into a frame (the first
+// frame after engine_start, or one after quiet gens). The hi-res engine has
+// no chars to build.
+void engine_draw(unsigned char *dst)
+{
+    if (engine == ENGINE_BITPACK)
+        packed_to_chars(dst);
+    else if (engine == ENGINE_UNIVERSE)
+        universe_to_chars(dst);
+    else if (engine == ENGINE_QUAD)
+        quad_to_chars(dst);
+    else if (engine != ENGINE_HIRES)
+        build_screen_from_current(dst);
+}
+
+// Compute the next gen with the selected engine (cells end up in current)
+void calc_next_gen_engine(void)
+{
+    bool keep = engine_keeps_history();
+    if (keep)
+        history_begin();
+
+    switch (engine)
+    {
+        case ENGINE_SEPARABLE:
+            calc_next_gen_separable();
+            swap_cells();
+            break;
+        case ENGINE_BITPACK:
+            calc_next_gen_packed();
+            break;
+        case ENGINE_DIRTY:
+            calc_next_gen_dirty();
+            swap_cells();
+            break;
+        case ENGINE_EVENTS:
+            calc_next_gen_events();
+            break;
+        case ENGINE_EDGE:
+            calc_next_gen_edge();
+            swap_cells();
+            break;
+        case ENGINE_UNIVERSE:
+            calc_next_gen_universe();
+            break;
+        case ENGINE_HIRES:
+            pack_generation();
+            break;
+        case ENGINE_QUAD:
+            calc_next_gen_quad();
+            break;
+        case ENGINE_INPLACE:
+            calc_next_gen_inplace();
+            break;
+        default:
+            calc_next_gen();
+            swap_cells();
+            break;
+    }
+
+    if (keep)
+        history_end();
+}
+
+// Compute-only gen, for gens that will not be shown: back is left as it
+// was, so engine_draw has to build the next frame that is
+void calc_next_gen_engine_quiet(void)
+{
+    drawing = false;
+    calc_next_gen_engine();
+    drawing = true;
+}
+
+// --- Period detection ---
+// A CRC-16 of the cells after each gen goes in a ring of the last
+// PERIOD_MAX gens; the grid has settled once the newest hash matches one of
+// them. The byte grid keeps one CRC per row and, when the engine tracks
+// changed rows, only recomputes those, so a settled board costs a few rows.
+#define PERIOD_RING 16
+
+// CRC-16/CCITT tables, split in bytes: one lookup per byte hashed
+static unsigned char crc_tab_lo[256], crc_tab_hi[256];
+static unsigned char crc_lo, crc_hi;
+
+static unsigned int row_hash[BHEIGHT];
+static bool hash_all;                   // row hashes not valid yet
+
+static unsigned int period_ring[PERIOD_RING];
+static unsigned char period_pos, period_fill, period_last;
+
+static void build_crc_tables(void)
+{
+    for (unsigned int i = 0; i < 256; ++i)
+    {
+        unsigned int c = i << 8;
+        for (unsigned char k = 0; k < 8; ++k)
+            c = (c & 0x8000) ? (c << 1) ^ 0x1021 : c << 1;
+        crc_tab_lo[i] = (unsigned char)c;
+        crc_tab_hi[i] = (unsigned char)(c >> 8);
+    }
+}
+
+static inline void crc_byte(unsigned char b)
+{
+    unsigned char i = crc_hi ^ b;
+    crc_hi = crc_lo ^ crc_tab_hi[i];
+    crc_lo = crc_tab_lo[i];
+}
+
+static unsigned int grid_hash(void)
+{
+    crc_lo = crc_hi = 0xFF;
+
+    if (engine == ENGINE_BITPACK || engine == ENGINE_UNIVERSE || engine == ENGINE_HIRES || engine == ENGINE_QUAD)
+    {
+        // Packed engines: the whole universe (the bitmap for hi-res)
+        for (unsigned char y = 0; y < pack_ph; ++y)
+        {
+            unsigned char *row = pack_rows[y];
+            for (unsigned char i = 0; i < pack_pw; ++i)
+                crc_byte(*pack_byte(row, i));
+        }
+        return ((unsigned int)crc_hi << 8) | crc_lo;
+    }
+
+    // Byte grid: rows that may have changed, then the CRC of the row CRCs
+    bool all = hash_all || !(engine == ENGINE_NAIVE || engine == ENGINE_SEPARABLE || engine == ENGINE_DIRTY ||
+                             engine == ENGINE_EDGE || engine == ENGINE_INPLACE);
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        if (all || row_dirty[y])
+        {
+            const unsigned char *row = CUR_ROW(y) + 1;
+            crc_lo = crc_hi = 0xFF;
+            for (unsigned char x = 0; x < WIDTH; ++x)
+                crc_byte(row[x]);
+            row_hash[y] = ((unsigned int)crc_hi << 8) | crc_lo;
+        }
+    }
+    hash_all = false;
+
+    crc_lo = crc_hi = 0xFF;
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        crc_byte((unsigned char)row_hash[y]);
+        crc_byte((unsigned char)(row_hash[y] >> 8));
+    }
+    return ((unsigned int)crc_hi << 8) | crc_lo;
+}
+
+void period_reset(void)
+{
+    if (!crc_tab_hi[1])
+        build_crc_tables();
+
+    hash_all = true;
+    period_pos = period_fill = period_last = 0;
+}
+
+// A match has to hold for two gens in a row before it counts, so a 16-bit
+// hash collision alone does not stop a run
+unsigned char period_check(void)
+{
+    unsigned int h = grid_hash();
+    unsigned char found = 0;
+
+    for (unsigned char p = 1; p <= period_fill; ++p)
+    {
+        if (period_ring[(period_pos - p) & (PERIOD_RING - 1)] == h)
+        {
+            found = p;
+            break;
+        }
+    }
+
+    period_ring[period_pos] = h;
+    period_pos = (period_pos + 1) & (PERIOD_RING - 1);
+    if (period_fill < PERIOD_MAX)
+        period_fill++;
+
+    unsigned char confirmed = (found && found == period_last) ? found : 0;
+    period_last = found;
+    return confirmed;
+}
+
+// Random cells from the generator, 8 per byte
+void grid_random(void)
+{
+    //  Clear the grid
+    memset(current, 0, BHEIGHT * BWIDTH);
+    random_start = true;
+
+    // Fill current cells (the first frame is built when the simulation starts)
+    for (unsigned char y = 1; y <= HEIGHT; y++)
+    {
+        unsigned char *row = CUR_ROW(y) + 1;
+        for (unsigned char i = 0; i < PWIDTH; i++, row += 8)
+            pack_byte_to_cells(random_cells(), row);
+    }
+}
+
+unsigned char *current_row(unsigned char y)
+{
+    return CUR_ROW(y);
+}
+
+// Build the chars for current into a screen (after editing/presets, first frame)
+void build_screen_from_current(unsigned char *dst)
+{
+    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    {
+        const unsigned char *row = CUR_ROW(y);
+        unsigned char *s = FRAME_ROW(dst, y) - 1;
+        for (unsigned char x = 1; x <= WIDTH; ++x)
+            s[x] = row[x] ? LIVE_CHAR : DEAD_CHAR;
+    }
+}
+
+// Draw a pattern (list of (dx,dy) pairs) with top-left anchor at (y0,x0)
+static void draw_preset(int y0, int x0, const signed char (*pts)[2], int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        int y = y0 + pts[i][1];
+        int x = x0 + pts[i][0];
+        if (y >= 1 && y <= HEIGHT && x >= 1 && x <= WIDTH)
+            CUR_ROW(y)[x] = 1;
+    }
+}
+
+// Clear the grid and place a preset near the middle
+void grid_preset(unsigned char preset)
+{
+    // Set start drawing pos
+    int cx = WIDTH/2, cy = HEIGHT/2;
+
+    memset(current, 0, BHEIGHT * BWIDTH);
+
+    switch (preset)
+    {
+        case PRESET_BLOCK:
+            draw_preset(cy, cx, P_BLOCK, N_BLOCK);
+            break;
+        case PRESET_BLINKER:
+            draw_preset(cy, cx-1, P_BLINKER, N_BLINKER);
+            break;
+        case PRESET_GLIDER:
+            draw_preset(cy-1, cx-1, P_GLIDER, N_GLIDER);
+            break;
+
+        // Leave space for gliders to fly
+        // It won't last long due to the C64's
+        // small screen and the toroidal wraparound :-(
+        // (unless run in the 128x128 universe)
+        case PRESET_GGUN:
+            draw_preset(3, 2, P_GGUN, N_GGUN);
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,186 @@
+// Conway's Game of Life for Commodore 64 - the portable core
+// Grid, rule tables and the generation engines. Nothing in here touches
+// the VIC, the CIAs or conio, so it also builds with gcc/clang on a host
+// (see tools/bench.c). Engines write their chars to the frame at back.
+
+#ifndef LIFE_H
+#define LIFE_H
+
+#include <stdbool.h>
+
+#define WIDTH 40
+#define HEIGHT 25
+#define BWIDTH (WIDTH + 2)
+#define BHEIGHT (HEIGHT + 2)
+
+// Map (y,x) to correct index in our 1D buffer (row-major)
+#define IDX(y,x) ((y) * BWIDTH + (x))
+
+// Live and Dead chars
+#define LIVE_CHAR 0x51
+#define DEAD_CHAR ' '
+
+// 128x128 universe behind a scrolling 40x25 viewport
+#define UWIDTH  128
+#define UHEIGHT 128
+#define UPWIDTH (UWIDTH / 8)
+
+// 320x200 hi-res bitmap, one pixel per cell, in the VIC's own layout:
+// 8x8 cells of 8 bytes, so a pixel row is 40 bytes spaced 8 apart
+#define HWIDTH  320
+#define HHEIGHT 200
+#define HPWIDTH (HWIDTH / 8)
+
+// 80x50 quad-cell universe, 2x2 cells per char
+#define QWIDTH  (WIDTH * 2)
+#define QHEIGHT (HEIGHT * 2)
+#define QPWIDTH (QWIDTH / 8)
+
+// Cell storage for the large universes, and the gen history ring. On the
+// C64 these live at the top of RAM (see the memory map in main.c); on a
+// host they are plain arrays. The history shares the bitmap's RAM: only
+// the 40x25 engines keep history, and they leave the bitmap alone.
+#define HISTORY_SIZE 0x3000
+
+#ifdef __OSCAR64C__
+#define UNIVERSE ((unsigned char *)0x9000)      // CPU-only RAM under the char ROM image
+#define BITMAP   ((unsigned char *)0xA000)      // hi-res bitmap, RAM under BASIC ROM
+#define HISTORY  ((unsigned char *)0xA000)      // $A000-$CFFF, RAM under BASIC ROM and above it
+#else
+extern unsigned char universe_cells[UHEIGHT * UPWIDTH];
+extern unsigned char bitmap_cells[HHEIGHT * HPWIDTH];
+extern unsigned char history_cells[HISTORY_SIZE];
+#define UNIVERSE universe_cells
+#define BITMAP   bitmap_cells
+#define HISTORY  history_cells
+#endif
+
+// Cell buffers (swapped via pointers)
+extern unsigned char *current;
+extern unsigned char *next;
+
+// Frame the engines build the next gen's chars in (40x25 screen codes)
+extern unsigned char *back;
+
+// Compiled rule and its normalised name, e.g. "B36/S23"
+extern char rule_name[24];
+
+// What compile_rule made of the string
+enum
+{
+    RULE_OK,
+    RULE_BAD_SYNTAX,    // not B<digits>/S<digits>
+    RULE_BAD_B0         // B0: empty space would have to flip
+};
+
+unsigned char compile_rule(const char *str);
+
+// Generation engines, selectable from the main menu so we can compare speed
+enum
+{
+    ENGINE_NAIVE,       // 8 loads + 7 adds per cell
+    ENGINE_SEPARABLE,   // column sums + sliding 3-column window
+    ENGINE_BITPACK,     // 1 bit per cell, bit-sliced adders, in place
+    ENGINE_DIRTY,       // naive kernel, skipping rows with a settled neighbourhood
+    ENGINE_EVENTS,      // only cells next to last gen's changes
+    ENGINE_EDGE,        // no halo: edge rows/columns read the opposite edge
+    ENGINE_UNIVERSE,    // 128x128 bit-packed universe, scrolling viewport
+    ENGINE_HIRES,       // 320x200 cells, 1 per pixel, straight on the bitmap
+    ENGINE_QUAD,        // 80x50 cells, 2x2 per char with a custom charset
+    ENGINE_INPLACE,     // edge kernel over one grid, changes applied a row late
+    ENGINE_COUNT
+};
+
+extern unsigned char engine;
+
+// Top-left cell of the viewport into the large universe
+extern unsigned char view_x, view_y;
+
+bool engine_uses_borders(void);
+void engine_start(void);
+void engine_stop(void);
+void engine_draw(unsigned char *dst);
+void calc_next_gen_engine(void);
+void calc_next_gen_engine_quiet(void);
+
+// Gen history of the 40x25 byte-grid engines, recorded as they compute.
+// history_back/forward step current one gen and redraw the changed cells in
+// dst (false at either end); history_resume runs on from there.
+// history_draw_last redraws only the last gen's changes in dst.
+bool engine_keeps_history(void);
+bool history_back(unsigned char *dst);
+bool history_forward(unsigned char *dst);
+void history_resume(void);
+void history_draw_last(unsigned char *dst);
+
+// Cell ages for a heat map over the same engines. ages_start counts the
+// live cells as newborn and fills col, a 40x25 colour frame, from the
+// colours of the AGE_BUCKETS; ages_update after each gen rewrites only the
+// colours of cells whose bucket changed.
+#define AGE_YOUNG_FROM  2
+#define AGE_OLD_FROM    8
+#define AGE_MAX         32      // ages saturate here: long-lived
+
+enum
+{
+    AGE_NEWBORN,        // born this gen
+    AGE_YOUNG,
+    AGE_OLD,
+    AGE_LONG,           // still lifes, mostly
+    AGE_BUCKETS
+};
+
+void ages_start(unsigned char *col, const unsigned char *colours);
+void ages_update(unsigned char *col);
+
+void update_borders(void);
+void build_wrap_tables(void);
+void build_screen_from_current(unsigned char *dst);
+
+// Row y of current (0..HEIGHT + 1, cells at 1..WIDTH) from the row tables,
+// for code outside the engines that walks the grid
+unsigned char *current_row(unsigned char y);
+#define ROW(y) current_row(y)
+
+// Period detection: call period_reset when a run starts, then
+// period_check after each gen. It returns the period (1..PERIOD_MAX) once
+// the cells have repeated for two gens in a row, so the grid has been
+// cycling since at most period + 1 gens ago; 0 while it is still changing.
+#define PERIOD_MAX 15
+
+void period_reset(void);
+unsigned char period_check(void);
+
+// Random starts come from a 16-bit generator seeded by random_seed, so a
+// seed reproduces a run (and its reseeds); density is the share of live cells
+enum
+{
+    DENSITY_12,         // 12.5%
+    DENSITY_25,
+    DENSITY_37,         // 37.5%
+    DENSITY_50,
+    DENSITY_COUNT
+};
+
+extern unsigned char density;
+
+void random_seed(unsigned int seed);
+
+// Starting grids: random cells from the generator, or a preset
+enum
+{
+    PRESET_BLOCK,
+    PRESET_BLINKER,
+    PRESET_GLIDER,
+    PRESET_GGUN,
+    PRESET_COUNT
+};
+
+void grid_random(void);
+void grid_preset(unsigned char preset);
+
+#ifdef __OSCAR64C__
+#pragma compile("life.c")
+#endif
+
+#endif
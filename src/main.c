@@ -2,19 +2,43 @@
 // By Ifor Evans
 // Tooling: VS Code, VS64 Extension, and the Oscar64 C Compiler
 
-// Toroidal 40x25 grid. Pointer-swapped cell buffers + single screen buffer.
+// Toroidal 40x25 grid. Pointer-swapped cell buffers + double-buffered screens.
 // Start menu (Random / Draw / Presets) prints in lower/uppercase (PETSCII)
+// The grid, rules and engines are in life.c; this file is the C64 side.
 
 #include <stdlib.h>
 #include <conio.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include "life.h"
 
-#define WIDTH 40
-#define HEIGHT 25
-#define BWIDTH (WIDTH + 2)
-#define BHEIGHT (HEIGHT + 2)
+// Raster-bar profiler: each main loop phase sets its own border colour, so
+// its share of the frame shows as a band (1 = on, compiles away when 0)
+#ifndef PROFILE_RASTER
+#define PROFILE_RASTER 0
+#endif
+
+#if PROFILE_RASTER
+#define PROFILE_PHASE(c) (*(volatile unsigned char *)0xD020 = (c))
+#else
+#define PROFILE_PHASE(c) ((void)0)
+#endif
+
+// Headless benchmark build for tools/c64bench (1 = on): no menus, no KERNAL
+// calls and no IRQs; every engine runs BENCH_GENS gens from the same seed and
+// reports through writes to the unused I/O area at $DE00
+#ifndef LIFE_BENCHMARK
+#define LIFE_BENCHMARK 0
+#endif
+
+// Border colours for the phases
+#define PHASE_BORDERS COLOR_RED
+#define PHASE_WAIT    COLOR_BLUE
+#define PHASE_COMPUTE COLOR_GREEN
+#define PHASE_DISPLAY COLOR_CYAN
+#define PHASE_KEYS    COLOR_YELLOW
+#define PHASE_IDLE    COLOR_BLACK
 
 // PETSCII codes for cursor keys on C64:
 // RIGHT=0x1D, LEFT=0x9D, DOWN=0x11, UP=0x91
@@ -23,46 +47,37 @@ const unsigned char KEY_LEFT  = 0x9D;
 const unsigned char KEY_DOWN  = 0x11;
 const unsigned char KEY_UP    = 0x91;
 
-// Map (y,x) to correct index in our 1D buffer (row-major)
-#define IDX(y,x) ((y) * BWIDTH + (x))
+// Any other key, from the direct keyboard scan in a run
+const unsigned char KEY_OTHER = 0xFF;
 
-// Cell buffers (swapped via pointers)
-static unsigned char buf0[BHEIGHT * BWIDTH];
-static unsigned char buf1[BHEIGHT * BWIDTH];
-static unsigned char *current = buf0;
-static unsigned char *next    = buf1;
-
-// Single off-screen display buffer (chars for the frame to be shown next)
-static unsigned char screenBuf[WIDTH * HEIGHT];
+// C64 screen memory (KERNAL text screen, used by the menus and the editor)
+static unsigned char *screen = (unsigned char *)0x0400;
 
-// Live and Dead chars
-#define LIVE_CHAR 0x51
-#define DEAD_CHAR ' '
+// --- Memory map ---
+// Code, data and stack stay below $8000 so VIC bank 2 ($8000-$BFFF) is free
+// for the simulation's two screen matrices. The VIC still sees the char ROM
+// at $9000 in this bank, so the graphics charset needs no copy, and the RAM
+// under it ($9000-$9FFF) is free for data only the CPU reads. UNIVERSE
+// ($9000), BITMAP ($A000) and the gen HISTORY ring ($A000-$CFFF, sharing
+// the bitmap's RAM) are defined with the engines in life.h.
+#pragma region(main, 0x0880, 0x8000, , , {code, data, bss, heap, stack})
 
-// C64 screen memory
-static unsigned char *screen = (unsigned char *)0x0400;
+#define SCREEN0 ((unsigned char *)0x8000)
+#define SCREEN1 ((unsigned char *)0x8400)
+#define QUAD_CHARSET ((unsigned char *)0x8800)  // 16 glyphs for the 80x50 mode
+#define METER_SPRITES ((unsigned char *)0x8C00) // 7 sprites for the cycle meter
 
-// --- Preset patterns ---
-static const signed char P_BLOCK[][2]   = { {0,0},{1,0},{0,1},{1,1} };
-static const signed char P_BLINKER[][2] = { {0,0},{1,0},{2,0} };
-static const signed char P_GLIDER[][2]  = { {1,0},{2,1},{0,2},{1,2},{2,2} };
-static const signed char P_GGUN[][2] =
-{
-    {0,4},{1,4},{0,5},{1,5},
-    {10,4},{10,5},{10,6},{11,3},{11,7},{12,2},{12,8},{13,2},{13,8},{14,5},{15,3},{15,7},{16,4},{16,5},{16,6},{17,5},
-    {20,2},{20,3},{20,4},{21,2},{21,3},{21,4},{22,1},{22,5},{24,0},{24,1},{24,5},{24,6},
-    {34,2},{34,3},{35,2},{35,3}
-};
+// $D018 values: screen at bank offset $0000/$0400, plus the charset, either
+// the uppercase ROM at $1000 or the quad-cell glyphs at $0800
+#define D018_SCREEN0 0x00
+#define D018_SCREEN1 0x10
+#define D018_ROM_CHARS  0x04
+#define D018_QUAD_CHARS 0x02
 
-#define N_BLOCK   (sizeof(P_BLOCK)/sizeof(P_BLOCK[0]))
-#define N_BLINKER (sizeof(P_BLINKER)/sizeof(P_BLINKER[0]))
-#define N_GLIDER  (sizeof(P_GLIDER)/sizeof(P_GLIDER[0]))
-#define N_GGUN    (sizeof(P_GGUN)/sizeof(P_GGUN[0]))
+static unsigned char d018_chars = D018_ROM_CHARS;
 
-// Branch-free rule tables
-// (This is very cool, and I cannot take credit for this innovation)
-static const unsigned char next_from_dead[9]  = {0,0,0,1,0,0,0,0,0};
-static const unsigned char next_from_alive[9] = {0,0,1,1,0,0,0,0,0};
+// Simulation frames: front is visible, back (in life.c) is being built by the engine
+static unsigned char *front = SCREEN0;
 
 // Charset helpers
 static inline void set_uppercase(void)
@@ -77,97 +92,807 @@ static inline void set_lowercase(void)
     *D018 = (unsigned char)(*D018 | 0x02);
 }
 
-// Copy horizontal and vertical borders to make the wrapping logic simpler
-void update_borders(void)
+// Hi-res display: bitmap at bank offset $2000, colours in SCREEN0
+#define D018_BITMAP 0x08
+#define BITMAP_COLOURS ((COLOR_LT_GREEN << 4) | COLOR_BLACK)
+
+static void bitmap_on(void)
+{
+    volatile unsigned char * const R01  = (unsigned char*)0x0001;
+    volatile unsigned char * const D011 = (unsigned char*)0xD011;
+
+    *R01 = 0x36;                            // BASIC ROM out, so the CPU reads the bitmap
+    memset(SCREEN0, BITMAP_COLOURS, WIDTH * HEIGHT);
+    *D011 = (unsigned char)(*D011 | 0x20);
+}
+
+static void bitmap_off(void)
+{
+    volatile unsigned char * const R01  = (unsigned char*)0x0001;
+    volatile unsigned char * const D011 = (unsigned char*)0xD011;
+
+    *D011 = (unsigned char)(*D011 & ~0x20);
+    *R01 = 0x37;
+}
+
+// Glyphs for the 80x50 mode: bit 3 of the glyph number is the top-left
+// 4x4 block, 2 top-right, 1 bottom-left, 0 bottom-right
+static void build_quad_charset(void)
 {
-    // Horizontal wrap: fix left/right border cells for each inner row.
-    unsigned char *row = current + IDX(1,0);
-    for (int y = 1; y <= HEIGHT; ++y, row += BWIDTH)
+    unsigned char *c = QUAD_CHARSET;
+    for (unsigned char g = 0; g < 16; ++g, c += 8)
     {
-        row[0] = row[WIDTH];        // left border <= right edge
-        row[BWIDTH - 1] = row[1];   // right border <= left edge
+        unsigned char top    = ((g & 8) ? 0xF0 : 0x00) | ((g & 4) ? 0x0F : 0x00);
+        unsigned char bottom = ((g & 2) ? 0xF0 : 0x00) | ((g & 1) ? 0x0F : 0x00);
+        c[0] = c[1] = c[2] = c[3] = top;
+        c[4] = c[5] = c[6] = c[7] = bottom;
     }
+}
 
-    // Vertical wrap: copy whole rows in one go (includes the updated borders).
-    memcpy(current + IDX(0,0),           current + IDX(HEIGHT,0),  BWIDTH);          // top border row
-    memcpy(current + IDX(BHEIGHT - 1,0), current + IDX(1,0),       BWIDTH);          // bottom border row
+static const char * const engine_names[ENGINE_COUNT] = { p"Naive", p"Separable", p"Bit-packed", p"Dirty rows", p"Change list", p"Wrap edges", p"128x128 universe", p"Hi-res 320x200", p"Quad 80x50", p"In place" };
+
+// The hi-res engine updates the visible bitmap in place, so it never flips
+static bool engine_flips_screens(void)
+{
+    return engine != ENGINE_HIRES;
 }
 
-// Calculate the next gen, and build the NEXT frame's characters in screenBuf
-void calc_next_gen(void)
+// Start the engine, with its display mode: the bitmap for hi-res, the
+// quad glyphs for 80x50, the ROM graphics chars for the rest
+static void sim_start(void)
 {
-    unsigned char *cur = current;
-    unsigned char *nxt = next;
+    volatile unsigned char * const R01 = (unsigned char*)0x0001;
 
-    for (unsigned char y = 1; y <= HEIGHT; ++y)
+    d018_chars = D018_ROM_CHARS;
+    if (engine == ENGINE_HIRES)
+    {
+        bitmap_on();
+        d018_chars = D018_BITMAP;
+    }
+    else if (engine == ENGINE_QUAD)
     {
-        unsigned char *row_above = cur + (y - 1) * BWIDTH;
-        unsigned char *row       = cur + y * BWIDTH;
-        unsigned char *row_below = cur + (y + 1) * BWIDTH;
-        unsigned char *out       = nxt + y * BWIDTH;
-        unsigned char *s         = screenBuf + (y - 1) * WIDTH;
+        build_quad_charset();
+        d018_chars = D018_QUAD_CHARS;
+    }
 
-        for (unsigned char x = 1; x <= WIDTH; ++x)
-        {
-            unsigned char neighbours =
-                row_above[x - 1] +
-                row_above[x] +
-                row_above[x + 1] +
-                row[x - 1] +
-                row[x + 1] +
-                row_below[x - 1] +
-                row_below[x] +
-                row_below[x + 1];
-
-            unsigned char alive = row[x];
-            unsigned char v = alive ? next_from_alive[neighbours] : next_from_dead[neighbours];
-
-            out[x] = v;
-            s[x - 1] = v ? LIVE_CHAR : DEAD_CHAR;
-        }
+    // The history ring is partly under the BASIC ROM
+    if (engine_keeps_history())
+        *R01 = 0x36;
+
+    engine_start();
+}
+
+static void sim_stop(void)
+{
+    volatile unsigned char * const R01 = (unsigned char*)0x0001;
+
+    engine_stop();
+    if (engine == ENGINE_HIRES)
+        bitmap_off();
+    if (engine_keeps_history())
+        *R01 = 0x37;
+    d018_chars = D018_ROM_CHARS;
+}
+
+// Cursor keys scroll the viewport of the large universe
+#define SCROLL_STEP 4
+
+// Handle a key during the simulation; false means back to the menu
+static bool engine_key(unsigned char key)
+{
+    if (engine != ENGINE_UNIVERSE)
+        return false;
+
+    switch (key)
+    {
+        case KEY_UP:    view_y = (unsigned char)((view_y - SCROLL_STEP) & (UHEIGHT - 1)); break;
+        case KEY_DOWN:  view_y = (unsigned char)((view_y + SCROLL_STEP) & (UHEIGHT - 1)); break;
+        case KEY_LEFT:  view_x = (unsigned char)((view_x - SCROLL_STEP) & (UWIDTH - 1));  break;
+        case KEY_RIGHT: view_x = (unsigned char)((view_x + SCROLL_STEP) & (UWIDTH - 1));  break;
+        default:
+            return false;
     }
+
+    return true;
+}
+
+// --- Random starts ---
+// The grid comes from life.c's generator, 8 cells per byte. Its seed is
+// the user's (menu S), so a run can be repeated, or else 16 bits of SID
+// voice 3 noise mixed with the raster line.
+static bool seed_fixed;
+static unsigned int user_seed;
+
+static const char * const density_names[DENSITY_COUNT] = { p"12.5%", p"25%  ", p"37.5%", p"50%  " };
+
+// Voice 3 on noise at the top frequency, silent (it is not gated)
+static void sid_noise_on(void)
+{
+    volatile unsigned char * const sid = (unsigned char*)0xD400;
+
+    sid[0x0E] = 0xFF;
+    sid[0x0F] = 0xFF;
+    sid[0x12] = 0x80;
+}
+
+static unsigned int noise_seed(void)
+{
+    volatile unsigned char * const sid  = (unsigned char*)0xD400;
+    volatile unsigned char * const D012 = (unsigned char*)0xD012;
+
+    unsigned char hi = sid[0x1B];
+    return ((unsigned int)hi << 8) | (unsigned char)(sid[0x1B] ^ *D012);
 }
 
+// Soup reseeds carry on from the same generator, so a seed repeats them too
 void initialize_grid_random(void)
 {
-    //  Get a (semi)random seed for srand by using the current raster line
-    volatile unsigned char *raster = (unsigned char *)0xD012;
-    srand(*raster);
+    random_seed(seed_fixed ? user_seed : noise_seed());
+    grid_random();
+}
 
-    //  Clear the grid
-    memset(current, 0, BHEIGHT * BWIDTH);
+// --- Screen flipping ---
+// The raster IRQ writes vbl_d018 at the bottom of the display when a flip is
+// pending, so the switch to the new frame never tears. During a run it is
+// the only IRQ: the CIA1 timer IRQ (the KERNAL's keyboard scan and clock)
+// is off, and the raster IRQ scans the keyboard itself, once a frame.
+#define VBL_RASTER_LINE 251
+
+static volatile unsigned char vbl_d018 = D018_SCREEN0 | D018_ROM_CHARS;
+static volatile unsigned char vbl_pending;
+static volatile unsigned char vbl_frames;       // counts up once a frame
+static void *kernal_irq;
+
+// Keyboard matrix: key_latch[c] gathers the keys seen down in column c
+// (bit r = row r) since sim_key last took them; key_down is non-zero while
+// any key is down
+static const unsigned char key_columns[8] = { 0xFE, 0xFD, 0xFB, 0xF7, 0xEF, 0xDF, 0xBF, 0x7F };
+static volatile unsigned char key_latch[8];
+static volatile unsigned char key_latched;
+static volatile unsigned char key_down;
 
-    // Fill current cells and build the initial screenBuf (first frame)
-    for (int y = 1; y <= HEIGHT; y++)
+// Chained in front of the KERNAL IRQ at $0314. Raster IRQs end at $EA81
+// (restore registers, RTI); a CIA timer IRQ would still go to the KERNAL.
+// All columns are tested at once, so the full scan only runs while a key is down.
+__asm vbl_irq
+{
+        lda $d019
+        and #$01
+        beq kernal
+        sta $d019
+        inc vbl_frames
+        lda vbl_pending
+        beq keys
+        lda vbl_d018
+        sta $d018
+        lda #0
+        sta vbl_pending
+    keys:
+        lda #$00
+        sta $dc00
+        lda $dc01
+        eor #$ff
+        sta key_down
+        beq done
+        ldx #7
+    scan:
+        lda key_columns, x
+        sta $dc00
+        lda $dc01
+        eor #$ff
+        ora key_latch, x
+        sta key_latch, x
+        dex
+        bpl scan
+        stx key_latched
+    done:
+        lda #$7f
+        sta $dc00
+        jmp $ea81
+    kernal:
+        jmp $ea31
+}
+
+// Take the keys seen since the last call: RETURN, the cursor keys, '+',
+// '-' or KEY_OTHER, and 0 for none (or only SHIFT)
+static unsigned char sim_key(void)
+{
+    unsigned char rows[8];
+
+    __asm { sei }
+    for (unsigned char c = 0; c < 8; ++c)
     {
-        int srow = (y - 1) * WIDTH;
-        for (int x = 1; x <= WIDTH; x++)
-        {
-            unsigned char v = (unsigned char)(rand() & 1);
-            current[IDX(y,x)] = v;
-            screenBuf[srow + (x - 1)] = v ? LIVE_CHAR : DEAD_CHAR;
-        }
+        rows[c] = key_latch[c];
+        key_latch[c] = 0;
+    }
+    key_latched = 0;
+    __asm { cli }
+
+    // Left SHIFT is column 1 row 7, right SHIFT column 6 row 4
+    bool shift = (rows[1] & 0x80) || (rows[6] & 0x10);
+    rows[1] &= 0x7F;
+    rows[6] &= 0xEF;
+
+    if (rows[0] & 0x02)
+        return 13;
+    if (rows[0] & 0x04)
+        return shift ? KEY_LEFT : KEY_RIGHT;
+    if (rows[0] & 0x80)
+        return shift ? KEY_UP : KEY_DOWN;
+    if (rows[5] & 0x01)
+        return '+';
+    if (rows[5] & 0x08)
+        return '-';
+
+    for (unsigned char c = 0; c < 8; ++c)
+        if (rows[c])
+            return KEY_OTHER;
+    return 0;
+}
+
+// Wait for all keys to go up, then for the next key
+static unsigned char wait_key(void)
+{
+    unsigned char key;
+
+    while (key_down)
+        ;
+    sim_key();
+
+    while (!(key = sim_key()))
+        ;
+    return key;
+}
+
+// $D018 value that shows back
+static unsigned char back_d018(void)
+{
+    return ((back == SCREEN0) ? D018_SCREEN0 : D018_SCREEN1) | d018_chars;
+}
+
+static void swap_frames(void)
+{
+    unsigned char *tmp = front;
+    front = back;
+    back = tmp;
+}
+
+// Show the frame built in back at the next vblank; back becomes the old front
+void update_display(void)
+{
+    vbl_d018 = back_d018();
+    vbl_pending = 1;
+    swap_frames();
+}
+
+// Wait until the flip is done, so back is no longer visible and can be drawn
+static void wait_display(void)
+{
+    while (vbl_pending)
+        ;
+}
+
+// --- Fast-forward (menu option 9) ---
+// Gens that are not shown run compute-only (no chars), so the frames fall
+// behind the cells; the next shown gen builds its frame in full from the
+// cells, and back catches up by a copy before frames are drawn
+// incrementally again.
+enum
+{
+    SHOW_EVERY,
+    SHOW_10,
+    SHOW_100,
+    SHOW_JUMP,          // nothing until SHOW_JUMP_GEN, then every gen
+    SHOW_MODES
+};
+
+#define SHOW_JUMP_GEN 1000
+
+enum
+{
+    FRAMES_SYNC,        // both frames follow the cells
+    FRAMES_FRONT,       // only the frame on screen is up to date
+    FRAMES_STALE        // gens have run since the last frame was built
+};
+
+static unsigned char show_mode;
+static unsigned char frames = FRAMES_SYNC;
+
+static const char * const show_names[SHOW_MODES] = { p"Every gen   ", p"Every 10th  ", p"Every 100th ", p"Jump to 1000" };
+
+// Is gen g shown?
+static bool show_gen(unsigned int g)
+{
+    switch (show_mode)
+    {
+        case SHOW_10:   return g % 10 == 0;
+        case SHOW_100:  return g % 100 == 0;
+        case SHOW_JUMP: return g >= SHOW_JUMP_GEN;
+        default:        return true;
+    }
+}
+
+// --- Age heat map (menu H) ---
+// With the byte-grid engines each live cell's colour shows how long it has
+// lived (see ages_update); colour RAM serves both screens.
+#define COLOUR_RAM ((unsigned char *)0xD800)
+
+static bool heat_on;
+static bool heat_run;                   // this run colours by age
+
+static const unsigned char heat_colours[AGE_BUCKETS] = { COLOR_WHITE, COLOR_YELLOW, COLOR_ORANGE, COLOR_LT_BLUE };
+
+// Both frames get the engine's current state (run start, reseed or the
+// end of a history browse), and the ages start again from it
+static void sim_first_frame(void)
+{
+    wait_display();
+    engine_draw(front);
+    memcpy(back, front, WIDTH * HEIGHT);
+    frames = FRAMES_SYNC;
+
+    if (heat_run)
+        ages_start(COLOUR_RAM, heat_colours);
+}
+
+// Put the cells on screen after gens that were not shown (pause, result)
+static void frames_catch_up(void)
+{
+    if (frames == FRAMES_STALE)
+    {
+        wait_display();
+        engine_draw(front);
+        frames = FRAMES_FRONT;
+    }
+}
+
+// --- Single screen (menu option 0) ---
+// Instead of building a whole frame in back and flipping, the byte-grid
+// engines compute quiet and their record of the gen's changed cells (see
+// history_draw_last) is written to the one screen at the next vblank, so
+// screen writes follow the activity and nothing tears while it is sparse.
+// The other engines keep flipping.
+enum
+{
+    SCREEN_FLIP,
+    SCREEN_CHANGES,
+    SCREEN_MODES
+};
+
+static unsigned char screen_mode;
+static bool changes_only;               // this run draws changes on one screen
+
+static const char * const screen_names[SCREEN_MODES] = { p"Flip frames ", p"Changes only" };
+
+static void show_changes(void)
+{
+    unsigned char f = vbl_frames;
+    while (vbl_frames == f)
+        ;
+
+    if (frames == FRAMES_STALE)
+        engine_draw(front);
+    else
+        history_draw_last(front);
+    frames = FRAMES_SYNC;
+}
+
+// Switch the VIC to the bank 2 screens and start the vblank IRQ
+static void sim_display_on(void)
+{
+    volatile unsigned char * const DD00 = (unsigned char*)0xDD00;
+    volatile unsigned char * const D011 = (unsigned char*)0xD011;
+    volatile unsigned char * const D012 = (unsigned char*)0xD012;
+    volatile unsigned char * const D019 = (unsigned char*)0xD019;
+    volatile unsigned char * const D01A = (unsigned char*)0xD01A;
+    volatile unsigned char * const D018 = (unsigned char*)0xD018;
+    volatile unsigned char * const cia1 = (unsigned char*)0xDC00;
+
+    vbl_pending = 0;
+    front = SCREEN0;
+    back  = SCREEN1;
+    sim_first_frame();
+
+    __asm { sei }
+    cia1[0x0D] = 0x7F;                                    // no timer IRQ, the raster IRQ scans keys
+    (void)cia1[0x0D];                                     // drop one already pending
+    memset((unsigned char *)key_latch, 0, sizeof(key_latch));
+    key_latched = 0;
+    kernal_irq = *(void **)0x0314;
+    *(void **)0x0314 = vbl_irq;
+    *D012 = VBL_RASTER_LINE;
+    *D011 = (unsigned char)(*D011 & 0x7F);
+    *D019 = 0x01;
+    *D01A = 0x01;
+    *D018 = D018_SCREEN0 | d018_chars;
+    *DD00 = (unsigned char)((*DD00 & ~0x03) | 0x01);     // VIC bank 2
+    __asm { cli }
+}
+
+// Back to the KERNAL screen at $0400 and the plain KERNAL IRQ, with its
+// keyboard scan. The keys have to be up first, or the menu would see the
+// one that ended the run.
+static void sim_display_off(void)
+{
+    volatile unsigned char * const DD00 = (unsigned char*)0xDD00;
+    volatile unsigned char * const D019 = (unsigned char*)0xD019;
+    volatile unsigned char * const D01A = (unsigned char*)0xD01A;
+    volatile unsigned char * const D018 = (unsigned char*)0xD018;
+    volatile unsigned char * const cia1 = (unsigned char*)0xDC00;
+    volatile unsigned char * const ndx  = (unsigned char*)0x00C6; // keys in the KERNAL buffer
+
+    while (key_down)
+        ;
+    wait_display();
+
+    __asm { sei }
+    *D01A = 0x00;
+    *D019 = 0x01;
+    *(void **)0x0314 = kernal_irq;
+    cia1[0x0D] = 0x81;                                    // timer A IRQ back on
+    *ndx = 0;
+    *DD00 = (unsigned char)(*DD00 | 0x03);                // VIC bank 0
+    *D018 = 0x15;                                         // $0400, uppercase
+    __asm { cli }
+}
+
+// --- Cycle meter (menu option 7) ---
+// CIA2 timer A runs 255..0 (256 cycles) and timer B counts its underflows,
+// so (TB << 8 | TA lo) is a 24-bit countdown of CPU cycles. Only the gen
+// before each redraw of the sprite overlay (every METER_GENS gens) takes
+// a 3-byte stamp between phases; the numbers are worked out at the
+// redraw. Every gen adds its length in TB ticks (256 cycles) to a 16-bit
+// window for gens/sec, and nothing runs while the meter is off.
+#define METER_GENS    8
+#define METER_CLOCK   985248UL          // PAL cycles per second
+#define METER_STAMPS  5                 // loop start, borders, wait, compute, display
+#define METER_CHARS   21                // 7 sprites of 3 chars
+#define METER_X       24
+#define METER_Y       234               // over the bottom two text rows
+
+static bool meter_on;
+static unsigned int generation;
+static bool meter_sample;               // this gen is stamped for the next redraw
+static unsigned char stamp_hi[METER_STAMPS], stamp_mid[METER_STAMPS], stamp_lo[METER_STAMPS];
+static unsigned int meter_last;         // TB at the start of the last gen
+static unsigned int meter_window;       // TB ticks of the gens since the window started
+static unsigned char meter_gens;        // and how many there were
+static unsigned char meter_font[64 * 8];  // screen codes 0-63 from the char ROM
+
+static void meter_init(void)
+{
+    volatile unsigned char * const R01 = (unsigned char*)0x0001;
+    volatile unsigned char * const cia2 = (unsigned char*)0xDD00;
+
+    // Font for the overlay: the char ROM is only visible with I/O banked out
+    __asm { sei }
+    *R01 = 0x33;
+    memcpy(meter_font, (unsigned char *)0xD000, sizeof(meter_font));
+    *R01 = 0x37;
+    __asm { cli }
+
+    cia2[0x0D] = 0x7F;                  // no NMIs from CIA2
+    cia2[0x04] = 0xFF;                  // timer A latch 255
+    cia2[0x05] = 0x00;
+    cia2[0x06] = 0xFF;                  // timer B latch 65535
+    cia2[0x07] = 0xFF;
+    cia2[0x0F] = 0x51;                  // B: count A underflows, load, start
+    cia2[0x0E] = 0x11;                  // A: continuous, load, start
+}
+
+// Record the cycle countdown; retried if timer B ticked while reading
+static inline void meter_stamp(unsigned char i)
+{
+    volatile unsigned char * const cia2 = (unsigned char*)0xDD00;
+    unsigned char mid;
+
+    if (!meter_sample)
+        return;
+
+    do
+    {
+        mid = cia2[0x06];
+        stamp_hi[i] = cia2[0x07];
+        stamp_lo[i] = cia2[0x04];
+    } while (mid != cia2[0x06]);
+
+    stamp_mid[i] = mid;
+}
+
+static unsigned long meter_value(unsigned char i)
+{
+    return ((unsigned long)stamp_hi[i] << 16) | ((unsigned int)stamp_mid[i] << 8) | stamp_lo[i];
+}
+
+// Cycles from stamp a to stamp b (the timer counts down)
+static unsigned long meter_cycles(unsigned char a, unsigned char b)
+{
+    return (meter_value(a) - meter_value(b)) & 0xFFFFFFUL;
+}
+
+// Timer B alone: the countdown in 256-cycle ticks
+static unsigned int meter_ticks(void)
+{
+    volatile unsigned char * const cia2 = (unsigned char*)0xDD00;
+    unsigned char lo, hi;
+
+    do
+    {
+        hi = cia2[0x07];
+        lo = cia2[0x06];
+    } while (hi != cia2[0x07]);
+
+    return ((unsigned int)hi << 8) | lo;
+}
+
+// At the start of a gen: add the last gen to the window, and stamp this
+// one if the overlay is redrawn after it. A window that would pass 16 bits
+// (17 s) keeps the gens it has.
+static void meter_lap(void)
+{
+    if (!meter_on)
+        return;
+
+    unsigned int now = meter_ticks();
+    unsigned int w = meter_window + (meter_last - now);
+    meter_last = now;
+    if (w >= meter_window)
+    {
+        meter_window = w;
+        meter_gens++;
     }
+
+    meter_sample = !((generation + 1) & (METER_GENS - 1));
+    meter_stamp(0);
 }
 
-// Build screenBuf from current (used after editing/presets), then show it
-static void build_screen_from_current(void)
+// Start a new gens/sec window from here (run start, or after a pause)
+static void meter_restart(void)
 {
-    for (int y = 1; y <= HEIGHT; ++y)
+    meter_last = meter_ticks();
+    meter_window = 0;
+    meter_gens = 0;
+    meter_sample = false;
+}
+
+static const unsigned long powers_of_ten[8] = { 10000000UL, 1000000UL, 100000UL, 10000UL, 1000UL, 100UL, 10UL, 1UL };
+
+// Right-aligned decimal in n digits (n <= 7), by subtracting powers of
+// ten; values that do not fit show as all 9s
+static char *meter_number(char *dst, unsigned long v, unsigned char n)
+{
+    if (v >= powers_of_ten[7 - n])
+        v = powers_of_ten[7 - n] - 1;
+
+    for (unsigned char i = 8 - n; i < 8; ++i)
     {
-        int srow = (y - 1) * WIDTH;
-        for (int x = 1; x <= WIDTH; ++x)
+        char d = '0';
+        while (v >= powers_of_ten[i])
         {
-            unsigned char v = current[IDX(y,x)];
-            screenBuf[srow + (x - 1)] = v ? LIVE_CHAR : DEAD_CHAR;
+            v -= powers_of_ten[i];
+            d++;
         }
+        *dst++ = d;
     }
+    return dst;
 }
 
-// Fast display: copy the prepared chars to the visible screen
-void update_display(void)
+// Draw one line of text (ASCII, uppercase) into the overlay sprites
+static void meter_text(unsigned char line, const char *text)
+{
+    for (unsigned char col = 0; col < METER_CHARS; ++col)
+    {
+        char c = text[col];
+        unsigned char code = (c >= 'A' && c <= 'Z') ? (unsigned char)(c - 64) : (unsigned char)(c & 0x3F);
+        const unsigned char *glyph = meter_font + code * 8;
+        unsigned char *d = METER_SPRITES + (col / 3) * 64 + line * 30 + (col % 3);
+
+        for (unsigned char r = 0; r < 8; ++r, d += 3)
+            *d = glyph[r];
+    }
+}
+
+// B = update_borders, C = calc_next_gen (in K cycles from a million on, for
+// the big engines), D = flip + vblank wait (and ages), in cycles for the
+// last gen; then the gen number and gens/sec over the last window. Each
+// line is exactly METER_CHARS long.
+static void meter_draw(void)
+{
+    char text[METER_CHARS + 1];
+    char *t = text;
+
+    unsigned long calc = meter_cycles(2, 3);
+
+    *t++ = 'B'; t = meter_number(t, meter_cycles(0, 1), 5); *t++ = ' ';
+    *t++ = 'C';
+    if (calc < 1000000UL)
+        t = meter_number(t, calc, 6);
+    else
+    {
+        t = meter_number(t, calc / 1000, 5);
+        *t++ = 'K';
+    }
+    *t++ = ' ';
+    *t++ = 'D'; t = meter_number(t, meter_cycles(1, 2) + meter_cycles(3, 4), 5);
+    *t = 0;
+    meter_text(0, text);
+
+    unsigned long rate = meter_window ? (meter_gens * (METER_CLOCK * 10 / 256)) / meter_window : 0;
+    meter_window = 0;
+    meter_gens = 0;
+
+    t = text;
+    *t++ = 'G'; t = meter_number(t, generation, 5); *t++ = ' ';
+    t = meter_number(t, rate / 10, 3); *t++ = '.'; t = meter_number(t, rate % 10, 1);
+    memcpy(t, " GEN/S   ", 9);
+    t[9] = 0;
+    meter_text(1, text);
+}
+
+// Sprites 0-6 side by side over the bottom rows, pointers in both screens
+static void meter_show(bool on)
+{
+    volatile unsigned char * const vic = (unsigned char*)0xD000;
+
+    if (!on)
+    {
+        vic[0x15] = 0x00;
+        return;
+    }
+
+    memset(METER_SPRITES, 0, 7 * 64);
+    for (unsigned char k = 0; k < 7; ++k)
+    {
+        unsigned char ptr = (unsigned char)((METER_SPRITES - SCREEN0) / 64 + k);
+        SCREEN0[0x3F8 + k] = ptr;
+        SCREEN1[0x3F8 + k] = ptr;
+        vic[2 * k]     = (unsigned char)(METER_X + 24 * k);
+        vic[2 * k + 1] = METER_Y;
+        vic[0x27 + k]  = COLOR_WHITE;
+    }
+    vic[0x10] = 0x00;
+    vic[0x17] = 0x00;
+    vic[0x1B] = 0x00;
+    vic[0x1C] = 0x00;
+    vic[0x1D] = 0x00;
+    vic[0x15] = 0x7F;
+}
+
+// --- Soup runner (menu option 8) ---
+// Once period_check sees the grid repeat, the result goes in the overlay
+// sprites; then the run either stops there or reseeds and carries on, so a
+// random soup can run unattended without burning time on a dead board.
+enum
+{
+    SOUP_OFF,
+    SOUP_STOP,          // show the result and wait for a key
+    SOUP_RESEED,        // show it for a moment, then a new random soup
+    SOUP_MODES
+};
+
+#define SOUP_HOLD     100               // frames the result stays up when reseeding
+#define SOUP_MAX_GENS 5000              // give up on soups that never settle (gliders)
+
+static unsigned char soup_mode;
+static unsigned int soup_count;
+
+static const char * const soup_names[SOUP_MODES] = { p"Off   ", p"Stop  ", p"Reseed" };
+
+// Report a settled soup (period 0 = gave up) and stop or reseed.
+// Returns false to go back to the menu.
+static bool soup_settled(unsigned char period)
 {
-    memcpy(screen, screenBuf, WIDTH * HEIGHT);
+    char text[METER_CHARS + 1];
+    char *t = text;
+
+    frames_catch_up();
+    meter_show(true);
+
+    if (period)
+    {
+        memcpy(t, "SETTLED AT GEN ", 15);
+        t = meter_number(t + 15, generation - period - 1, 5);
+        *t++ = ' ';
+    }
+    else
+    {
+        memcpy(t, "NO PERIOD AT ", 13);
+        t = meter_number(t + 13, generation, 5);
+        *t++ = ' '; *t++ = ' '; *t++ = ' ';
+    }
+    *t = 0;
+    meter_text(0, text);
+
+    t = text;
+    memcpy(t, "PERIOD ", 7);
+    t = meter_number(t + 7, period, 2);
+    if (soup_mode == SOUP_STOP)
+    {
+        memcpy(t, "     ANY KEY", 12);
+        t += 12;
+    }
+    else
+    {
+        memcpy(t, "  SOUP ", 7);
+        t = meter_number(t + 7, ++soup_count, 5);
+    }
+    *t = 0;
+    meter_text(1, text);
+
+    if (soup_mode == SOUP_STOP)
+    {
+        wait_key();
+        return false;
+    }
+
+    unsigned char start = vbl_frames;
+    while ((unsigned char)(vbl_frames - start) < SOUP_HOLD)
+    {
+        if (sim_key())
+            return false;
+    }
+
+    grid_random();
+    engine_start();
+    sim_first_frame();
+    period_reset();
+    generation = 0;
+
+    meter_show(meter_on);
+    meter_restart();
+    return true;
+}
+
+// --- History browser ---
+// '-' in a run pauses it a gen back; then '-' and '+' step through the
+// recorded gens, RETURN runs on from the one shown (the later gens are
+// dropped) and any other key goes back to the menu. Returns true to run on.
+static bool history_browse(void)
+{
+    char text[METER_CHARS + 1];
+    unsigned int steps = 0;
+
+    frames_catch_up();
+    meter_show(true);
+    meter_text(1, "-/+ STEP  RETURN=RUN ");
+
+    // front is the frame on screen (or about to be)
+    unsigned char key = '-';
+    while (true)
+    {
+        if (key == '-' && history_back(front))
+        {
+            generation--;
+            steps++;
+        }
+        else if (key == '+' && history_forward(front))
+        {
+            generation++;
+            steps--;
+        }
+        else if (key == 13)
+            break;
+        else if (key != '-' && key != '+')
+            return false;
+
+        char *t = text;
+        memcpy(t, "GEN ", 4);
+        t = meter_number(t + 4, generation, 5);
+        memcpy(t, "  BACK ", 7);
+        t = meter_number(t + 7, steps, 5);
+        *t = 0;
+        meter_text(0, text);
+
+        key = wait_key();
+    }
+
+    history_resume();
+    sim_first_frame();
+    period_reset();
+
+    meter_show(meter_on);
+    meter_restart();
+    return true;
 }
 
 void set_colours(void)
@@ -177,12 +902,11 @@ void set_colours(void)
     textcolor(COLOR_LT_GREEN);
 }
 
-// Clear entire inner grid (and screenBuf)
+// Clear entire inner grid (and the screen)
 static void clear_grid(void)
 {
     memset(current, 0, BHEIGHT * BWIDTH);
-    memset(screenBuf, DEAD_CHAR, WIDTH * HEIGHT);
-    update_display();
+    memset(screen, DEAD_CHAR, WIDTH * HEIGHT);
 }
 
 // Simple editor (cursor keys move, SPACE toggle, X clears all, C clears row, ENTER starts)
@@ -193,8 +917,7 @@ static void draw_editor(void)
     set_uppercase();
 
     // Set up display
-    build_screen_from_current();
-    update_display();
+    build_screen_from_current(screen);
 
     // Valid values for co-ords = 1..WIDTH / 1..HEIGHT (0 is border wraps)
     // And initial position in the middle of the screen
@@ -218,10 +941,10 @@ static void draw_editor(void)
             // Toggle current cell?
             case ' ':
             {
-                unsigned char v = (unsigned char)(current[IDX(cy,cx)] ^ 1);
-                current[IDX(cy,cx)] = v;
-                screenBuf[pos] = v ? LIVE_CHAR : DEAD_CHAR;
-                screen[pos]     = screenBuf[pos];
+                unsigned char *row = ROW(cy);
+                unsigned char v = (unsigned char)(row[cx] ^ 1);
+                row[cx] = v;
+                screen[pos] = v ? LIVE_CHAR : DEAD_CHAR;
             } break;
 
             // Clear all?
@@ -234,16 +957,13 @@ static void draw_editor(void)
             case 'c':
             case 'C':
             {
-                for (int x = 1; x <= WIDTH; ++x) current[IDX(cy,x)] = 0;
-                memset(screenBuf + (cy - 1) * WIDTH, DEAD_CHAR, WIDTH);
-                memcpy(screen + (cy - 1) * WIDTH, screenBuf + (cy - 1) * WIDTH, WIDTH);
+                memset(ROW(cy) + 1, 0, WIDTH);
+                memset(screen + (cy - 1) * WIDTH, DEAD_CHAR, WIDTH);
             } break;
 
             // Start simulation?
             case 13:
             case 10:
-                build_screen_from_current();
-                update_display();
                 return;
 
             case KEY_UP:
@@ -268,22 +988,6 @@ static void draw_editor(void)
     }
 }
 
-// Draw a pattern (list of (dx,dy) pairs) with top-left anchor at (y0,x0)
-static void draw_preset(int y0, int x0, const signed char (*pts)[2], int n)
-{
-    for (int i = 0; i < n; ++i)
-    {
-        int y = y0 + pts[i][1];
-        int x = x0 + pts[i][0];
-        if (y >= 1 && y <= HEIGHT && x >= 1 && x <= WIDTH)
-        {
-            current[IDX(y,x)] = 1;
-            screenBuf[(y - 1) * WIDTH + (x - 1)] = LIVE_CHAR;
-        }
-    }
-    update_display();
-}
-
 static void show_presets_menu(void)
 {
     clrscr();
@@ -295,43 +999,193 @@ static void show_presets_menu(void)
     printf(p"U=Glider Gun\r\r");
     printf(p"Enter=cancel)\r");
 
-    // Set start drawing pos
-    int cx = WIDTH/2, cy = HEIGHT/2;
-
     // Wait for user keypress
     unsigned char key = (unsigned char)getch();
     switch (key)
     {
         case 'b': 
         case 'B':
-            clear_grid();
-            draw_preset(cy, cx, P_BLOCK, N_BLOCK);
+            grid_preset(PRESET_BLOCK);
             break;
         case 'n': 
         case 'N':
-            clear_grid();
-            draw_preset(cy, cx-1, P_BLINKER, N_BLINKER);
+            grid_preset(PRESET_BLINKER);
             break;
         case 'g': 
         case 'G':
-            clear_grid();
-            draw_preset(cy-1, cx-1, P_GLIDER, N_GLIDER);
+            grid_preset(PRESET_GLIDER);
             break;
-
-        // Leave space for gliders to fly
-        // It won't last long due to the C64's
-        // small screen and the toroidal wraparound :-(
         case 'u': 
         case 'U':
-            clear_grid();
-            draw_preset(3, 2, P_GGUN, N_GGUN);
+            grid_preset(PRESET_GGUN);
+            break;
+        default:
+            break;
+    }
+
+    build_screen_from_current(screen);
+}
+
+// Menu row showing the selected engine
+#define RANDOM_MENU_ROW 3
+#define ENGINE_MENU_ROW 16
+
+#define RULE_MENU_ROW   17
+#define METER_MENU_ROW  18
+#define SOUP_MENU_ROW   19
+#define SHOW_MENU_ROW   20
+#define SCREEN_MENU_ROW 21
+#define HEAT_MENU_COL   26
+#define PROMPT_MENU_ROW 23
+
+static void print_random(void)
+{
+    gotoxy(0, RANDOM_MENU_ROW);
+    printf(p"   D) Density %s  S) Seed ", density_names[density]);
+    if (seed_fixed)
+        printf(p"%u     \r", user_seed);
+    else
+        printf(p"Random\r");
+}
+
+static void print_engine(void)
+{
+    gotoxy(0, ENGINE_MENU_ROW);
+    printf(p"5) Engine: %s      \r", engine_names[engine]);
+}
+
+// The rule name is padded to the end of the row, which a 20-char name
+// such as B12345678/S012345678 still leaves clear of the last column
+#define RULE_FIELD      30
+
+static void print_rule(void)
+{
+    char pad[RULE_FIELD + 1];
+    unsigned char n = (unsigned char)strlen(rule_name);
+
+    n = (n < RULE_FIELD) ? RULE_FIELD - n : 0;
+    memset(pad, ' ', n);
+    pad[n] = 0;
+
+    gotoxy(0, RULE_MENU_ROW);
+    printf(p"6) Rule: %s%s\r", rule_name, pad);
+}
+
+static void print_meter(void)
+{
+    gotoxy(0, METER_MENU_ROW);
+    printf(meter_on ? p"7) Meter: On \r" : p"7) Meter: Off\r");
+}
+
+static void print_soup(void)
+{
+    gotoxy(0, SOUP_MENU_ROW);
+    printf(p"8) Soup: %s\r", soup_names[soup_mode]);
+}
+
+static void print_show(void)
+{
+    gotoxy(0, SHOW_MENU_ROW);
+    printf(p"9) Show: %s\r", show_names[show_mode]);
+}
+
+static void print_screen(void)
+{
+    gotoxy(0, SCREEN_MENU_ROW);
+    printf(p"0) Screen: %s", screen_names[screen_mode]);
+}
+
+static void print_heat(void)
+{
+    gotoxy(HEAT_MENU_COL, SCREEN_MENU_ROW);
+    printf(heat_on ? p"H) Ages: On \r" : p"H) Ages: Off\r");
+}
+
+// Read a line of up to max chars, echoed at (x,y) (DEL deletes, RETURN ends)
+static void read_line(char *buf, unsigned char max, unsigned char x, unsigned char y)
+{
+    unsigned char n = 0;
+    buf[0] = 0;
+
+    while (true)
+    {
+        char c = (char)getch();
+
+        if (c == 13 || c == 10)
+            break;
+
+        if ((c == 8 || c == 20) && n > 0)
+            buf[--n] = 0;
+        else if (c >= ' ' && c < 127 && n < max)
+        {
+            buf[n++] = c;
+            buf[n] = 0;
+        }
+
+        gotoxy(x, y);
+        printf("%s ", buf);
+    }
+}
+
+// Ask for a new B/S rule string below the menu
+static void enter_rule(void)
+{
+    char buf[20];
+
+    gotoxy(0, PROMPT_MENU_ROW);
+    printf(p"Rule (e.g. B36/S23): ");
+    read_line(buf, 18, 21, PROMPT_MENU_ROW);
+
+    gotoxy(0, PROMPT_MENU_ROW);
+    switch (compile_rule(buf))
+    {
+        case RULE_OK:
+            printf(p"                                       ");
+            break;
+        case RULE_BAD_B0:
+            printf(p"Bad rule (B0 not supported)            ");
             break;
         default:
+            printf(p"Bad rule (use e.g. B36/S23)            ");
             break;
     }
 
-    build_screen_from_current();
-    update_display();
+    print_rule();
+}
+
+// Ask for a seed for the random starts; RETURN alone goes back to SID noise.
+// Anything but a number 1-65535 asks again (0 would be the same soup as
+// 44257, see random_seed).
+static void enter_seed(void)
+{
+    char buf[8];
+    const char *prompt = p"Seed (RETURN = random): ";
+
+    while (true)
+    {
+        gotoxy(0, PROMPT_MENU_ROW);
+        printf(p"                                       ");
+        gotoxy(0, PROMPT_MENU_ROW);
+        printf("%s", prompt);
+        read_line(buf, 5, 24, PROMPT_MENU_ROW);
+
+        unsigned long v = 0;
+        const char *c = buf;
+        for (; *c >= '0' && *c <= '9'; ++c)
+            v = v * 10 + (unsigned char)(*c - '0');
+
+        if (!*c && (buf[0] == 0 || (v != 0 && v <= 0xFFFF)))
+        {
+            seed_fixed = buf[0] != 0;
+            user_seed = (unsigned int)v;
+            break;
+        }
+        prompt = p"Bad seed, 1-65535 only: ";
+    }
+
+    gotoxy(0, PROMPT_MENU_ROW);
+    printf(p"                                       ");
+    print_random();
 }
 
 // Returns 1 to start the simulation, 0 to quit to BASIC.
@@ -342,7 +1196,9 @@ static bool show_main_menu(void)
     clrscr();
     gotoxy(0,0);
     printf(p"Conway's Game of Life\r\r");
-    printf(p"1) Random start\r\r");
+    printf(p"1) Random start\r");
+    print_random();
+    printf(p"\r");
     printf(p"2) Draw your own\r");
     printf(p"   Cursor keys to move,\r");
     printf(p"   SPACE = toggle,\r");
@@ -352,7 +1208,14 @@ static bool show_main_menu(void)
     printf(p"3) Presets\r");
     printf(p"   Block, Blinker, Glider, Glider Gun\r\r");
     printf(p"4) Quit\r\r");
-    printf(p"\rChoose 1-4: ");
+    print_engine();
+    print_rule();
+    print_meter();
+    print_soup();
+    print_show();
+    print_screen();
+    print_heat();
+    printf(p"Choose 0-9, D, S or H: ");
 
     // Loop until done
     while (true)
@@ -383,14 +1246,157 @@ static bool show_main_menu(void)
         { 
             return false; 
         }
+
+        if (key == '5')
+        {
+            engine = (unsigned char)((engine + 1) % ENGINE_COUNT);
+            print_engine();
+        }
+
+        if (key == '6')
+        {
+            enter_rule();
+        }
+
+        if (key == '7')
+        {
+            meter_on = !meter_on;
+            print_meter();
+        }
+
+        if (key == '8')
+        {
+            soup_mode = (unsigned char)((soup_mode + 1) % SOUP_MODES);
+            print_soup();
+        }
+
+        if (key == '9')
+        {
+            show_mode = (unsigned char)((show_mode + 1) % SHOW_MODES);
+            print_show();
+        }
+
+        if (key == '0')
+        {
+            screen_mode = (unsigned char)((screen_mode + 1) % SCREEN_MODES);
+            print_screen();
+        }
+
+        if (key == 'h' || key == 'H')
+        {
+            heat_on = !heat_on;
+            print_heat();
+        }
+
+        if (key == 'd' || key == 'D')
+        {
+            density = (unsigned char)((density + 1) % DENSITY_COUNT);
+            print_random();
+        }
+
+        if (key == 's' || key == 'S')
+        {
+            enter_seed();
+        }
     }
 }
 
 //  Main entry point for our app
+#if LIFE_BENCHMARK
+
+// Start grid and length of each engine's run
+#ifndef BENCH_SEED
+#define BENCH_SEED 1
+#endif
+#ifndef BENCH_GENS
+#define BENCH_GENS 20
+#endif
+
+// Only every Nth gen builds a frame, as with the fast-forward modes
+#ifndef BENCH_EVERY
+#define BENCH_EVERY 1
+#endif
+
+// Marker port: engine starts, one gen done, engine done, all done
+#define BENCH_PORT ((volatile unsigned char *)0xDE00)
+#define BENCH_START 0
+#define BENCH_GEN   1
+#define BENCH_END   2
+#define BENCH_EXIT  3
+
 int main(void)
 {
-    // Setup display
+    volatile unsigned char * const DD00 = (unsigned char*)0xDD00;
+    volatile unsigned char * const D011 = (unsigned char*)0xD011;
+    volatile unsigned char * const D018 = (unsigned char*)0xD018;
+
+    // No IRQs, and a blank screen so the VIC steals no cycles (no badlines)
+    __asm { sei }
+    *D011 = (unsigned char)(*D011 & ~0x10);
+    *DD00 = (unsigned char)((*DD00 & ~0x03) | 0x01);     // VIC bank 2
+
+    compile_rule("B3/S23");
+    build_wrap_tables();
+
+    for (unsigned char e = 0; e < ENGINE_COUNT; ++e)
+    {
+        random_seed(BENCH_SEED);
+        grid_random();
+        engine = e;
+        sim_start();
+
+        front = SCREEN0;
+        back  = SCREEN1;
+        engine_draw(front);
+        memcpy(back, front, WIDTH * HEIGHT);
+
+        // Same phases as the main loop, but flipping straight away
+        BENCH_PORT[BENCH_START] = e;
+        for (unsigned int g = 0; g < BENCH_GENS; ++g)
+        {
+            if (engine_uses_borders())
+                update_borders();
+
+            if ((g + 1) % BENCH_EVERY)
+                calc_next_gen_engine_quiet();
+            else
+            {
+                if (BENCH_EVERY == 1)
+                    calc_next_gen_engine();
+                else
+                {
+                    calc_next_gen_engine_quiet();
+                    engine_draw(back);
+                }
+
+                if (engine_flips_screens())
+                {
+                    *D018 = back_d018();
+                    swap_frames();
+                }
+            }
+
+            BENCH_PORT[BENCH_GEN] = 0;
+        }
+        BENCH_PORT[BENCH_END] = e;
+
+        sim_stop();
+    }
+
+    BENCH_PORT[BENCH_EXIT] = 0;
+    return 0;
+}
+
+#else
+
+int main(void)
+{
+    // Setup display and tables
     set_colours();
+    compile_rule("B3/S23");
+    build_wrap_tables();
+    meter_init();
+    sid_noise_on();
 
     // Loop: menu -> simulate -> back to menu (until Quit)
     while (show_main_menu())
@@ -398,26 +1404,102 @@ int main(void)
         // Prepare to run simulation
         clrscr();
         set_uppercase();
-        build_screen_from_current();
-        update_display();
+        sim_start();
+        changes_only = screen_mode == SCREEN_CHANGES && engine_keeps_history();
+        heat_run = heat_on && engine_keeps_history();
+        sim_display_on();
+        period_reset();
+        soup_count = 0;
+        generation = 0;
+        meter_show(meter_on);
+        meter_restart();
 
         // Simulation loop: any key returns to the main menu
         while (true)
         {
-            // show frame prepared in previous iteration
-            update_display();
+            meter_lap();
 
             // wrap borders
-            update_borders();
+            PROFILE_PHASE(PHASE_BORDERS);
+            if (engine_uses_borders())
+                update_borders();
+            meter_stamp(1);
 
-            // compute next gen + build next frame's chars
-            calc_next_gen();
+            // back must be hidden before the engine draws into it
+            PROFILE_PHASE(PHASE_WAIT);
+            bool show = show_gen(generation + 1);
+            if (show && !changes_only)
+            {
+                wait_display();
+                if (frames == FRAMES_FRONT)
+                {
+                    memcpy(back, front, WIDTH * HEIGHT);
+                    frames = FRAMES_SYNC;
+                }
+            }
+            meter_stamp(2);
+
+            // compute next gen + build next frame's chars in back (swaps cells),
+            // or just the cells for a gen that is not shown
+            PROFILE_PHASE(PHASE_COMPUTE);
+            if (changes_only)
+            {
+                calc_next_gen_engine_quiet();
+                if (!show)
+                    frames = FRAMES_STALE;
+            }
+            else if (show && frames == FRAMES_SYNC)
+                calc_next_gen_engine();
+            else
+            {
+                calc_next_gen_engine_quiet();
+                if (show)
+                {
+                    engine_draw(back);
+                    frames = FRAMES_FRONT;
+                }
+                else
+                    frames = FRAMES_STALE;
+            }
+            meter_stamp(3);
+
+            // show it at the next vblank
+            PROFILE_PHASE(PHASE_DISPLAY);
+            if (show && changes_only)
+                show_changes();
+            else if (show && engine_flips_screens())
+                update_display();
+            if (heat_run)
+                ages_update(COLOUR_RAM);
+            meter_stamp(4);
 
-            // swap cells
-            { unsigned char *tmp = current; current = next; next = tmp; }
+            generation++;
+            if (meter_on && !(generation & (METER_GENS - 1)))
+                meter_draw();
 
-            if (kbhit()) { getch(); break; }  // back to menu
+            // settled (or hopeless) soups stop or reseed
+            if (soup_mode != SOUP_OFF)
+            {
+                unsigned char period = period_check();
+                if ((period || (soup_mode == SOUP_RESEED && generation >= SOUP_MAX_GENS)) && !soup_settled(period))
+                    break;
+            }
+
+            // back to menu (unless the engine or the history uses the key)
+            PROFILE_PHASE(PHASE_KEYS);
+            if (key_latched)
+            {
+                unsigned char key = sim_key();
+                if (key && !engine_key(key) && !(key == '-' && engine_keeps_history() && history_browse()))
+                    break;
+            }
+            PROFILE_PHASE(PHASE_IDLE);
         }
+        PROFILE_PHASE(PHASE_IDLE);
+
+        meter_show(false);
+        sim_stop();
+        sim_display_off();
     }
 
     // Back to BASIC
@@ -429,3 +1511,5 @@ int main(void)
     // All done
     return 0;
 }
+
+#endif
@@ -0,0 +1,172 @@
+// Host benchmark for the Life core (src/life.c)
+// Runs N generations of each engine from a fixed seed or a preset and
+// reports the time per cell update, so algorithmic changes can be measured
+// without an emulator. Host timings say nothing about 6502 cycles, only
+// about the amount of work each engine does. With -k K only every Kth gen
+// builds a frame, as in the C64's fast-forward modes.
+//
+//   bench [-e engine|all] [-n gens] [-k K] [-s seed | -p preset] [-d density] [-r rule]
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "life.h"
+#include "engines.h"
+
+static const char * const preset_ids[PRESET_COUNT] = { "block", "blinker", "glider", "gun" };
+static const char * const density_ids[DENSITY_COUNT] = { "12", "25", "37", "50" };
+
+static int lookup(const char *name, const char * const *ids, int count)
+{
+    for (int i = 0; i < count; ++i)
+        if (!strcmp(name, ids[i]))
+            return i;
+    return -1;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: bench [-e engine|all] [-n gens] [-k K] [-s seed | -p preset] [-d density] [-r rule]\n");
+    fprintf(stderr, "engines:");
+    for (int i = 0; i < ENGINE_COUNT; ++i)
+        fprintf(stderr, " %s", engine_ids[i]);
+    fprintf(stderr, "\npresets:");
+    for (int i = 0; i < PRESET_COUNT; ++i)
+        fprintf(stderr, " %s", preset_ids[i]);
+    fprintf(stderr, "\ndensities (%%):");
+    for (int i = 0; i < DENSITY_COUNT; ++i)
+        fprintf(stderr, " %s", density_ids[i]);
+    fprintf(stderr, "\n");
+    exit(2);
+}
+
+// Same order of calls as the C64 main loop, with two host frames standing
+// in for the flipped screens; gens between every Kth are compute-only
+static void run(unsigned char e, long gens, long every, unsigned int seed, int preset)
+{
+    static unsigned char frames[2][WIDTH * HEIGHT];
+
+    if (preset >= 0)
+        grid_preset((unsigned char)preset);
+    else
+    {
+        random_seed((unsigned int)seed);
+        grid_random();
+    }
+
+    engine = e;
+    engine_start();
+    engine_draw(frames[0]);
+    memcpy(frames[1], frames[0], WIDTH * HEIGHT);
+    back = frames[1];
+
+    double t0 = now_ns();
+    for (long g = 0; g < gens; ++g)
+    {
+        if (engine_uses_borders())
+            update_borders();
+
+        if (every == 1)
+            calc_next_gen_engine();
+        else if ((g + 1) % every)
+        {
+            calc_next_gen_engine_quiet();
+            continue;
+        }
+        else
+        {
+            calc_next_gen_engine_quiet();
+            engine_draw(back);
+        }
+        back = (back == frames[0]) ? frames[1] : frames[0];
+    }
+    double t = now_ns() - t0;
+
+    engine_stop();
+
+    // Population and a checksum of the 40x25 window, to compare engines and runs
+    unsigned int pop = 0, sum = 0;
+    for (int y = 1; y <= HEIGHT; ++y)
+        for (int x = 1; x <= WIDTH; ++x)
+        {
+            pop += current[IDX(y,x)];
+            sum = sum * 31 + current[IDX(y,x)];
+        }
+
+    printf("%-10s %6ld cells %7ld gens %9.3f ms %8.3f ns/cell   pop %4u  sum %08x\n",
+           engine_ids[e], engine_cells(e), gens, t / 1e6, t / ((double)gens * engine_cells(e)), pop, sum);
+}
+
+int main(int argc, char **argv)
+{
+    int e = -1, preset = -1;
+    long gens = 1000, every = 1;
+    unsigned int seed = 1;
+    const char *rule = "B3/S23";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (i + 1 >= argc || arg[0] != '-' || arg[2])
+            usage();
+
+        const char *val = argv[++i];
+        switch (arg[1])
+        {
+            case 'e':
+                if (strcmp(val, "all") && (e = lookup(val, engine_ids, ENGINE_COUNT)) < 0)
+                    usage();
+                break;
+            case 'n':
+                gens = atol(val);
+                break;
+            case 'k':
+                every = atol(val);
+                break;
+            case 's':
+                seed = (unsigned int)strtoul(val, NULL, 0);
+                break;
+            case 'p':
+                if ((preset = lookup(val, preset_ids, PRESET_COUNT)) < 0)
+                    usage();
+                break;
+            case 'd':
+            {
+                int d = lookup(val, density_ids, DENSITY_COUNT);
+                if (d < 0)
+                    usage();
+                density = (unsigned char)d;
+            } break;
+            case 'r':
+                rule = val;
+                break;
+            default:
+                usage();
+        }
+    }
+
+    if (gens <= 0 || every <= 0 || compile_rule(rule) != RULE_OK)
+        usage();
+    build_wrap_tables();
+
+    if (preset >= 0)
+        printf("rule %s, %ld gens (every %ld shown), preset %s\n", rule_name, gens, every, preset_ids[preset]);
+    else
+        printf("rule %s, %ld gens (every %ld shown), seed %u, density %s%%\n", rule_name, gens, every, seed, density_ids[density]);
+
+    for (int i = 0; i < ENGINE_COUNT; ++i)
+        if (e < 0 || e == i)
+            run((unsigned char)i, gens, every, seed, preset);
+
+    return 0;
+}
@@ -0,0 +1,366 @@
+// Minimal C64 memory model around the 6502 core, for the host tools
+
+#include <stdio.h>
+#include <string.h>
+#include "c64.h"
+
+// Return address pushed by c64_call; reaching it ends the call
+#define CALL_SENTINEL 0xFFF8
+
+// KERNAL jump table entries used by c64_kernal_init
+#define KERNAL_CINT   0xFF81
+#define KERNAL_IOINIT 0xFF84
+#define KERNAL_RAMTAS 0xFF87
+#define KERNAL_RESTOR 0xFF8A
+
+void c64_init(c64 *m)
+{
+    memset(m, 0, sizeof(*m));
+    m->ram[0x0000] = 0x2F;              // processor port: data direction
+    m->ram[0x0001] = 0x37;              // BASIC, KERNAL and I/O in
+
+    m->cia1.ta = m->cia1.tb = m->cia1.ta_latch = m->cia1.tb_latch = 0xFFFF;
+    m->cia2.ta = m->cia2.tb = m->cia2.ta_latch = m->cia2.tb_latch = 0xFFFF;
+
+    m->cpu.ctx = m;
+    m->cpu.read = c64_read;
+    m->cpu.write = c64_write;
+    m->cpu.s = 0xFF;
+    m->cpu.p = FLAG_U | FLAG_I;
+}
+
+// Port bits, with inputs (DDR bit clear) pulled high
+static uint8_t port(const c64 *m)
+{
+    return (uint8_t)((m->ram[1] | ~m->ram[0]) & 0x07);
+}
+
+int c64_rom_at(const c64 *m, uint16_t addr)
+{
+    uint8_t p = port(m);
+
+    if (addr >= 0xA000 && addr < 0xC000 && (p & 0x03) == 0x03 && m->has_basic)
+        return ROM_BASIC;
+    if (addr >= 0xE000 && (p & 0x02) && m->has_kernal)
+        return ROM_KERNAL;
+    if (addr >= 0xD000 && addr < 0xE000 && (p & 0x03) && !(p & 0x04) && m->has_chargen)
+        return ROM_CHARGEN;
+    return ROM_NONE;
+}
+
+static bool io_visible(const c64 *m)
+{
+    uint8_t p = port(m);
+    return (p & 0x03) && (p & 0x04);
+}
+
+// Raster line from the cycle count: 63 cycles a line, 312 lines a frame
+static unsigned int raster(const c64 *m)
+{
+    return (unsigned int)((m->cpu.cycles / C64_LINE_CYCLES) % C64_FRAME_LINES);
+}
+
+static uint8_t cia_read(cia *t, uint8_t r)
+{
+    switch (r & 0x0F)
+    {
+        case 0x01: return 0xFF;                         // port B: no key down
+        case 0x04: return (uint8_t)t->ta;
+        case 0x05: return (uint8_t)(t->ta >> 8);
+        case 0x06: return (uint8_t)t->tb;
+        case 0x07: return (uint8_t)(t->tb >> 8);
+        case 0x0D:
+        {
+            // Reading acknowledges everything pending
+            uint8_t v = (uint8_t)(t->icr | ((t->icr & t->mask) ? 0x80 : 0x00));
+            t->icr = 0;
+            return v;
+        }
+        case 0x0E: return t->cra;
+        case 0x0F: return t->crb;
+        default:   return 0xFF;
+    }
+}
+
+static void cia_write(cia *t, uint8_t r, uint8_t v)
+{
+    switch (r & 0x0F)
+    {
+        case 0x04: t->ta_latch = (uint16_t)((t->ta_latch & 0xFF00) | v); break;
+        case 0x05:
+            t->ta_latch = (uint16_t)((t->ta_latch & 0x00FF) | (v << 8));
+            if (!(t->cra & 0x01))
+                t->ta = t->ta_latch;
+            break;
+        case 0x06: t->tb_latch = (uint16_t)((t->tb_latch & 0xFF00) | v); break;
+        case 0x07:
+            t->tb_latch = (uint16_t)((t->tb_latch & 0x00FF) | (v << 8));
+            if (!(t->crb & 0x01))
+                t->tb = t->tb_latch;
+            break;
+        case 0x0D:
+            if (v & 0x80)
+                t->mask |= v & 0x1F;
+            else
+                t->mask &= (uint8_t)~v;
+            break;
+        case 0x0E:
+            if (v & 0x10)
+                t->ta = t->ta_latch;                    // force load (strobe, not kept)
+            t->cra = v & (uint8_t)~0x10;
+            break;
+        case 0x0F:
+            if (v & 0x10)
+                t->tb = t->tb_latch;
+            t->crb = v & (uint8_t)~0x10;
+            break;
+    }
+}
+
+// One timer count: underflow sets its ICR bit and reloads the latch.
+// Returns true on underflow.
+static bool timer_count(uint16_t *counter, uint16_t latch, uint8_t *cr, uint8_t *icr, uint8_t bit)
+{
+    if (*counter)
+    {
+        (*counter)--;
+        return false;
+    }
+
+    *counter = latch;
+    *icr |= bit;
+    if (*cr & 0x08)
+        *cr &= (uint8_t)~0x01;                          // one-shot stops
+    return true;
+}
+
+static void cia_tick(cia *t, int cycles)
+{
+    for (int i = 0; i < cycles; ++i)
+    {
+        bool under = false;
+
+        if ((t->cra & 0x21) == 0x01)                    // started, counting cycles
+            under = timer_count(&t->ta, t->ta_latch, &t->cra, &t->icr, 0x01);
+
+        if (t->crb & 0x01)
+        {
+            uint8_t mode = (t->crb >> 5) & 0x03;
+            if (mode == 0 || (mode == 2 && under))      // cycles, or timer A underflows
+                timer_count(&t->tb, t->tb_latch, &t->crb, &t->icr, 0x02);
+        }
+    }
+}
+
+static uint8_t vic_read(c64 *m, uint8_t r)
+{
+    r &= 0x3F;
+    switch (r)
+    {
+        case 0x11: return (uint8_t)((m->io[0x11] & 0x7F) | ((raster(m) >> 1) & 0x80));
+        case 0x12: return (uint8_t)raster(m);
+        case 0x19: return (uint8_t)(m->io[0x19] | 0x70 | ((m->io[0x19] & m->io[0x1A] & 0x0F) ? 0x80 : 0x00));
+        default:   return m->io[r];
+    }
+}
+
+static void vic_write(c64 *m, uint8_t r, uint8_t v)
+{
+    r &= 0x3F;
+    if (r == 0x19)
+        m->io[0x19] &= (uint8_t)~(v & 0x0F);           // acknowledge
+    else
+        m->io[r] = v;
+}
+
+static uint8_t io_read(c64 *m, uint16_t addr)
+{
+    switch (addr & 0xFF00)
+    {
+        case 0xD000:
+        case 0xD100:
+        case 0xD200:
+        case 0xD300:
+            return vic_read(m, (uint8_t)addr);
+        case 0xDC00:
+            return cia_read(&m->cia1, (uint8_t)addr);
+        case 0xDD00:
+            if ((addr & 0x0F) == 0x00)
+                return m->io[0xD00];                    // VIC bank bits as written
+            return cia_read(&m->cia2, (uint8_t)addr);
+        case 0xDE00:
+        case 0xDF00:
+            return 0xFF;                                // open expansion port
+        default:
+            return m->io[addr & 0x0FFF];
+    }
+}
+
+uint8_t c64_read(void *ctx, uint16_t addr)
+{
+    c64 *m = ctx;
+
+    switch (c64_rom_at(m, addr))
+    {
+        case ROM_BASIC:   return m->basic[addr - 0xA000];
+        case ROM_KERNAL:  return m->kernal[addr - 0xE000];
+        case ROM_CHARGEN: return m->chargen[addr - 0xD000];
+    }
+
+    if (addr >= 0xD000 && addr < 0xE000 && io_visible(m))
+        return io_read(m, addr);
+
+    return m->ram[addr];
+}
+
+void c64_write(void *ctx, uint16_t addr, uint8_t v)
+{
+    c64 *m = ctx;
+
+    if (addr >= 0xD000 && addr < 0xE000 && io_visible(m))
+    {
+        switch (addr & 0xFF00)
+        {
+            case 0xD000:
+            case 0xD100:
+            case 0xD200:
+            case 0xD300:
+                vic_write(m, (uint8_t)addr, v);
+                break;
+            case 0xDC00:
+                cia_write(&m->cia1, (uint8_t)addr, v);
+                break;
+            case 0xDD00:
+                if ((addr & 0x0F) == 0x00)
+                    m->io[0xD00] = v;
+                else
+                    cia_write(&m->cia2, (uint8_t)addr, v);
+                break;
+            case 0xDE00:
+                if (m->mark)
+                    m->mark(m, (uint8_t)addr, v);
+                break;
+            default:
+                m->io[addr & 0x0FFF] = v;
+                break;
+        }
+        return;
+    }
+
+    // Writes under the ROMs always reach RAM
+    m->ram[addr] = v;
+}
+
+int c64_step(c64 *m)
+{
+    cpu6502 *c = &m->cpu;
+    uint16_t pc = c->pc;
+    bool irq = c->irq && !(c->p & FLAG_I);
+
+    int n = cpu_step(c);
+
+    cia_tick(&m->cia1, n);
+    cia_tick(&m->cia2, n);
+
+    // Raster compare: latched once as the beam reaches the line
+    unsigned int line = raster(m);
+    if (line != m->line)
+    {
+        unsigned int cmp = m->io[0x12] | ((m->io[0x11] & 0x80) << 1);
+        if (line == cmp)
+            m->io[0x19] |= 0x01;
+        m->line = line;
+    }
+
+    c->irq = (m->cia1.icr & m->cia1.mask) || (m->io[0x19] & m->io[0x1A] & 0x0F);
+
+    if (m->trace)
+        m->trace(m, pc, n, irq);
+
+    return n;
+}
+
+bool c64_load_prg(c64 *m, const char *path, uint16_t *sys)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+
+    int lo = fgetc(f), hi = fgetc(f);
+    if (lo == EOF || hi == EOF)
+    {
+        fclose(f);
+        return false;
+    }
+
+    uint16_t load = (uint16_t)(lo | (hi << 8));
+    size_t n = fread(m->ram + load, 1, sizeof(m->ram) - load, f);
+    fclose(f);
+
+    // BASIC stub: link, line number, then SYS (token $9E) and its digits
+    *sys = 0;
+    if (load == 0x0801 && n > 6)
+    {
+        const uint8_t *b = m->ram + 0x0805;
+        while (*b == ' ')
+            b++;
+        if (*b++ == 0x9E)
+        {
+            unsigned int a = 0;
+            while (*b == ' ')
+                b++;
+            while (*b >= '0' && *b <= '9')
+                a = a * 10 + (unsigned int)(*b++ - '0');
+            *sys = (uint16_t)a;
+        }
+    }
+
+    return true;
+}
+
+bool c64_load_rom(const char *path, uint8_t *dst, long size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+
+    long n = (long)fread(dst, 1, (size_t)size, f);
+    fclose(f);
+    return n == size;
+}
+
+bool c64_kernal_init(c64 *m)
+{
+    static const uint16_t steps[] = { KERNAL_IOINIT, KERNAL_RAMTAS, KERNAL_RESTOR, KERNAL_CINT };
+
+    if (!m->has_kernal)
+        return false;
+
+    m->cpu.p |= FLAG_I;
+    for (unsigned int i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i)
+        if (!c64_call(m, steps[i], 10000000, NULL))
+            return false;
+    m->cpu.p &= (uint8_t)~FLAG_I;
+
+    return true;
+}
+
+bool c64_call(c64 *m, uint16_t addr, uint64_t max_cycles, bool *stop)
+{
+    cpu6502 *c = &m->cpu;
+    uint64_t end = c->cycles + max_cycles;
+
+    c->s -= 2;
+    m->ram[0x0100 + (uint8_t)(c->s + 1)] = (uint8_t)(CALL_SENTINEL - 1);
+    m->ram[0x0100 + (uint8_t)(c->s + 2)] = (uint8_t)((CALL_SENTINEL - 1) >> 8);
+    c->pc = addr;
+
+    while (c->pc != CALL_SENTINEL)
+    {
+        if ((stop && *stop) || c->jammed || c->cycles >= end)
+            return false;
+        c64_step(m);
+    }
+
+    return true;
+}
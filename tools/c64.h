@@ -0,0 +1,86 @@
+// Minimal C64 memory model around the 6502 core, for the host tools
+// 64K RAM with the $01 banking of the BASIC, KERNAL and char ROMs (each
+// optional: without an image, reads fall through to RAM), the VIC raster
+// counter and raster IRQ, the CIA timers (CIA1 drives IRQ), and the
+// benchmark marker port at $DE00. No VIC DMA: badlines are not modelled.
+
+#ifndef C64_H
+#define C64_H
+
+#include "cpu6502.h"
+
+#define C64_CLOCK         985248        // PAL cycles per second
+#define C64_LINE_CYCLES   63
+#define C64_FRAME_LINES   312
+
+// Benchmark markers written by the LIFE_BENCHMARK build (see src/main.c):
+// $DE00 = engine starts, $DE01 = one gen done, $DE02 = engine done, $DE03 = exit
+#define MARK_PORT   0xDE00
+#define MARK_START  0
+#define MARK_GEN    1
+#define MARK_END    2
+#define MARK_EXIT   3
+
+// Which ROM (if any) the CPU sees at an address
+enum
+{
+    ROM_NONE,
+    ROM_BASIC,
+    ROM_KERNAL,
+    ROM_CHARGEN
+};
+
+// CIA 6526 timers and interrupt control (no TOD, serial or ports)
+typedef struct cia
+{
+    uint16_t ta, tb, ta_latch, tb_latch;
+    uint8_t  cra, crb;
+    uint8_t  icr, mask;                 // pending and enabled interrupt sources
+} cia;
+
+typedef struct c64
+{
+    cpu6502 cpu;
+    cia cia1, cia2;
+    unsigned int line;                  // raster line at the last step
+
+    uint8_t ram[0x10000];
+    uint8_t io[0x1000];                 // last values written to $D000-$DFFF
+    uint8_t basic[0x2000], kernal[0x2000], chargen[0x1000];
+    bool has_basic, has_kernal, has_chargen;
+
+    // Called for each write to the marker port
+    void (*mark)(struct c64 *m, uint8_t port, uint8_t v);
+
+    // Called after each step with the pc it started at and its cycles;
+    // irq is set when the step was an interrupt entry rather than an instruction
+    void (*trace)(struct c64 *m, uint16_t pc, int cycles, bool irq);
+    void *user;
+} c64;
+
+void c64_init(c64 *m);
+
+// Load a .prg at its own load address; returns false if unreadable.
+// *sys is the address of the SYS in its BASIC stub (0 if there is none).
+bool c64_load_prg(c64 *m, const char *path, uint16_t *sys);
+
+// Load an 8K or 4K ROM image into dst; returns false on a bad file
+bool c64_load_rom(const char *path, uint8_t *dst, long size);
+
+// Run KERNAL IOINIT, RAMTAS, RESTOR and CINT through the jump table, as the
+// reset routine does, so KERNAL calls and the timer IRQ work (needs the ROM)
+bool c64_kernal_init(c64 *m);
+
+// One instruction (or IRQ entry), then the timers and raster catch up
+int c64_step(c64 *m);
+
+int c64_rom_at(const c64 *m, uint16_t addr);
+
+// Call addr as if by JSR from the sentinel, returning when it comes back
+// there (true), or false if the cpu jams or max_cycles pass first
+bool c64_call(c64 *m, uint16_t addr, uint64_t max_cycles, bool *stop);
+
+uint8_t c64_read(void *ctx, uint16_t addr);
+void c64_write(void *ctx, uint16_t addr, uint8_t v);
+
+#endif
@@ -0,0 +1,136 @@
+// Headless cycle benchmark for the C64 build
+// Loads a PRG built with -dLIFE_BENCHMARK=1 into the 6502/C64 model, runs
+// it from the SYS in its BASIC stub, and turns the $DE00 markers it writes
+// into exact CPU cycles per generation for each engine. The benchmark build
+// blanks the screen and runs with IRQs off, so there is no VIC DMA or IRQ
+// time to model and the numbers match a real machine.
+//
+//   c64bench [-m max_cycles] life.prg
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "c64.h"
+#include "engines.h"
+
+typedef struct bench_run
+{
+    int      engine;
+    long     gens;
+    uint64_t start, last, min, max;
+    bool     done;
+} bench_run;
+
+static bench_run runs[ENGINE_COUNT];
+static bench_run *cur;
+static bool finished;
+
+static void mark(c64 *m, uint8_t port, uint8_t v)
+{
+    uint64_t now = m->cpu.cycles;
+
+    switch (port)
+    {
+        case MARK_START:
+            if (v >= ENGINE_COUNT)
+            {
+                fprintf(stderr, "bad engine %u at $%04x\n", v, m->cpu.pc);
+                finished = true;
+                return;
+            }
+            cur = &runs[v];
+            cur->engine = v;
+            cur->gens = 0;
+            cur->start = cur->last = now;
+            cur->min = UINT64_MAX;
+            cur->max = 0;
+            break;
+
+        case MARK_GEN:
+            if (cur)
+            {
+                uint64_t d = now - cur->last;
+                cur->last = now;
+                cur->gens++;
+                if (d < cur->min) cur->min = d;
+                if (d > cur->max) cur->max = d;
+            }
+            break;
+
+        case MARK_END:
+            if (cur)
+                cur->done = true;
+            cur = NULL;
+            break;
+
+        case MARK_EXIT:
+            finished = true;
+            break;
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: c64bench [-m max_cycles] life.prg\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    static c64 m;
+    uint64_t max_cycles = 4000000000ULL;
+    const char *prg = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-m") && i + 1 < argc)
+            max_cycles = strtoull(argv[++i], NULL, 0);
+        else if (argv[i][0] != '-' && !prg)
+            prg = argv[i];
+        else
+            usage();
+    }
+
+    if (!prg)
+        usage();
+
+    c64_init(&m);
+    m.mark = mark;
+
+    uint16_t sys;
+    if (!c64_load_prg(&m, prg, &sys) || !sys)
+    {
+        fprintf(stderr, "%s: cannot load, or no SYS line\n", prg);
+        return 1;
+    }
+
+    c64_call(&m, sys, max_cycles, &finished);
+
+    printf("%-10s %6s %5s %10s %10s %10s %9s %8s\n", "engine", "cells", "gens", "cycles/gen", "min", "max", "cyc/cell", "gens/s");
+    int shown = 0;
+    for (int e = 0; e < ENGINE_COUNT; ++e)
+    {
+        const bench_run *r = &runs[e];
+        if (!r->done || !r->gens)
+            continue;
+
+        double avg = (double)(r->last - r->start) / r->gens;
+        printf("%-10s %6ld %5ld %10.0f %10llu %10llu %9.1f %8.2f\n", engine_ids[e], engine_cells((unsigned char)e), r->gens,
+               avg, (unsigned long long)r->min, (unsigned long long)r->max, avg / engine_cells((unsigned char)e), C64_CLOCK / avg);
+        shown++;
+    }
+
+    if (m.cpu.jammed)
+    {
+        fprintf(stderr, "cpu jammed at $%04x (opcode $%02x)\n", m.cpu.pc, c64_read(&m, m.cpu.pc));
+        return 1;
+    }
+    if (!finished)
+    {
+        fprintf(stderr, "no exit marker after %llu cycles\n", (unsigned long long)m.cpu.cycles);
+        return 1;
+    }
+
+    return shown ? 0 : 1;
+}
@@ -0,0 +1,447 @@
+// Per-function cycle profiler for the C64 build
+// Runs a PRG in the 6502/C64 model and charges every cycle to the function
+// it was spent in, using the labels Oscar64 writes next to the PRG (.lbl,
+// VICE "al" format; the .map, if present, gives each function's size).
+// Cycles inside an IRQ handler are kept apart from the same code called
+// from the main line, and the KERNAL/BASIC ROMs count as one function each.
+//
+// With a KERNAL image (-k) the normal build runs as on a real machine, with
+// the timer IRQ and GETIN/keyboard buffer: -t types menu keys (e.g. "51"
+// picks the next engine, then a random start) and profiling starts once the
+// last key has been read. Without one, run a -dLIFE_BENCHMARK=1 build.
+//
+//   c64prof [-k kernal.rom] [-b basic.rom] [-g chargen.rom] [-t keys]
+//           [-c cycles] [-l file.lbl] [-m file.map] [-n top] [-f function] life.prg
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "c64.h"
+
+#define MAX_SYMBOLS 4096
+#define MAX_NAME    64
+#define KEY_GAP     200000              // cycles between typed keys (menus redraw)
+
+typedef struct symbol
+{
+    uint16_t start;
+    uint32_t end;                       // one past the last byte (0 = up to the next symbol)
+    char     name[MAX_NAME];
+} symbol;
+
+// Pseudo functions after the real symbols
+enum
+{
+    PSEUDO_KERNAL,
+    PSEUDO_BASIC,
+    PSEUDO_UNKNOWN,
+    PSEUDO_IRQ_ENTRY,
+    PSEUDO_COUNT
+};
+
+static const char * const pseudo_names[PSEUDO_COUNT] = { "[KERNAL ROM]", "[BASIC ROM]", "[unknown]", "[IRQ entry]" };
+
+static symbol   syms[MAX_SYMBOLS];
+static int      nsyms;
+static int16_t  sym_at[0x10000];        // symbol owning each address, -1 for none
+
+static uint64_t fn_cycles[MAX_SYMBOLS + PSEUDO_COUNT][2];   // [function][in IRQ]
+static uint64_t fn_calls[MAX_SYMBOLS + PSEUDO_COUNT];
+static uint64_t pc_cycles[0x10000], pc_count[0x10000];
+static uint64_t total;
+
+static const char *keys = "";
+static uint64_t last_key;
+static bool     profiling, finished;
+static uint64_t limit = 20000000, prof_start;
+static int      irq_depth;
+
+static int by_start(const void *a, const void *b)
+{
+    const symbol *x = a, *y = b;
+    return (int)x->start - (int)y->start;
+}
+
+static void add_symbol(uint16_t start, uint32_t end, const char *name)
+{
+    // The .map repeats the labels; keep one entry, with the size if known
+    for (int i = 0; i < nsyms; ++i)
+        if (syms[i].start == start && !strcmp(syms[i].name, name))
+        {
+            if (end)
+                syms[i].end = end;
+            return;
+        }
+
+    if (nsyms == MAX_SYMBOLS)
+        return;
+
+    syms[nsyms].start = start;
+    syms[nsyms].end = end;
+    snprintf(syms[nsyms].name, MAX_NAME, "%s", name);
+    nsyms++;
+}
+
+// VICE labels: "al C:0880 .main" (the C: and the dot are optional)
+static bool load_lbl(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+
+    char line[256], name[MAX_NAME];
+    while (fgets(line, sizeof(line), f))
+    {
+        const char *p = line;
+        unsigned int addr;
+
+        if (strncmp(p, "al ", 3))
+            continue;
+        p += 3;
+        if (!strncmp(p, "C:", 2))
+            p += 2;
+        if (sscanf(p, "%x %63s", &addr, name) != 2)
+            continue;
+        add_symbol((uint16_t)addr, 0, name[0] == '.' ? name + 1 : name);
+    }
+
+    fclose(f);
+    return true;
+}
+
+// Map lines with an address range or a start and size, then the name:
+// "0880 - 08c2 : name, ..." or "0880 (0042) : name, ..."
+static bool load_map(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+
+    char line[256], name[MAX_NAME];
+    while (fgets(line, sizeof(line), f))
+    {
+        unsigned int a, b;
+
+        if (sscanf(line, "%x - %x : %63[^,\n ]", &a, &b, name) == 3 && b >= a && a < 0x10000)
+            add_symbol((uint16_t)a, b + 1, name);
+        else if (sscanf(line, "%x (%x) : %63[^,\n ]", &a, &b, name) == 3 && a < 0x10000)
+            add_symbol((uint16_t)a, a + b, name);
+    }
+
+    fclose(f);
+    return true;
+}
+
+static void build_sym_at(void)
+{
+    qsort(syms, (size_t)nsyms, sizeof(syms[0]), by_start);
+
+    for (int a = 0; a < 0x10000; ++a)
+        sym_at[a] = -1;
+
+    // Later (higher) symbols win, so an unsized one runs up to the next
+    for (int i = 0; i < nsyms; ++i)
+    {
+        uint32_t end = syms[i].end;
+        if (!end)
+            end = (i + 1 < nsyms) ? syms[i + 1].start : 0x10000;
+        for (uint32_t a = syms[i].start; a < end && a < 0x10000; ++a)
+            sym_at[a] = (int16_t)i;
+    }
+}
+
+static int function_of(const c64 *m, uint16_t pc)
+{
+    switch (c64_rom_at(m, pc))
+    {
+        case ROM_KERNAL: return MAX_SYMBOLS + PSEUDO_KERNAL;
+        case ROM_BASIC:  return MAX_SYMBOLS + PSEUDO_BASIC;
+    }
+    return sym_at[pc] >= 0 ? sym_at[pc] : MAX_SYMBOLS + PSEUDO_UNKNOWN;
+}
+
+static const char *function_name(int f)
+{
+    return f >= MAX_SYMBOLS ? pseudo_names[f - MAX_SYMBOLS] : syms[f].name;
+}
+
+// Code bytes as the CPU sees them, without touching I/O
+static uint8_t peek(const c64 *m, uint16_t addr)
+{
+    switch (c64_rom_at(m, addr))
+    {
+        case ROM_BASIC:  return m->basic[addr - 0xA000];
+        case ROM_KERNAL: return m->kernal[addr - 0xE000];
+    }
+    return m->ram[addr];
+}
+
+static void type_keys(c64 *m)
+{
+    if (!*keys)
+    {
+        // Start once the last key has been taken
+        if (!profiling && m->ram[0xC6] == 0)
+        {
+            profiling = true;
+            prof_start = m->cpu.cycles;
+        }
+        return;
+    }
+
+    if (m->ram[0xC6] == 0 && m->cpu.cycles - last_key > KEY_GAP)
+    {
+        m->ram[0x0277] = (uint8_t)*keys++;
+        m->ram[0xC6] = 1;
+        last_key = m->cpu.cycles;
+    }
+}
+
+static void trace(c64 *m, uint16_t pc, int cycles, bool irq)
+{
+    if (!profiling)
+    {
+        type_keys(m);
+        if (!profiling)
+            return;
+    }
+
+    total += (uint64_t)cycles;
+    if (total >= limit)
+        finished = true;
+
+    if (irq)
+    {
+        irq_depth++;
+        fn_cycles[MAX_SYMBOLS + PSEUDO_IRQ_ENTRY][1] += (uint64_t)cycles;
+        return;
+    }
+
+    int f = function_of(m, pc);
+    fn_cycles[f][irq_depth > 0] += (uint64_t)cycles;
+    pc_cycles[pc] += (uint64_t)cycles;
+    pc_count[pc]++;
+
+    uint8_t op = peek(m, pc);
+    if (op == 0x40 && irq_depth > 0)
+        irq_depth--;
+    else if (op == 0x20)
+        fn_calls[function_of(m, (uint16_t)(peek(m, (uint16_t)(pc + 1)) | (peek(m, (uint16_t)(pc + 2)) << 8)))]++;
+}
+
+static void mark(c64 *m, uint8_t port, uint8_t v)
+{
+    (void)m;
+    (void)v;
+    if (port == MARK_EXIT)
+        finished = true;
+}
+
+static void print_flat(void)
+{
+    static int order[(MAX_SYMBOLS + PSEUDO_COUNT) * 2];
+    int n = 0;
+
+    for (int f = 0; f < MAX_SYMBOLS + PSEUDO_COUNT; ++f)
+        for (int q = 0; q < 2; ++q)
+            if (fn_cycles[f][q])
+                order[n++] = f * 2 + q;
+
+    // Insertion sort by cycles, largest first
+    for (int i = 1; i < n; ++i)
+        for (int j = i; j > 0 && fn_cycles[order[j] / 2][order[j] % 2] > fn_cycles[order[j - 1] / 2][order[j - 1] % 2]; --j)
+        {
+            int t = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = t;
+        }
+
+    printf("Flat profile: %llu cycles, %.2f s or %.1f frames (PAL)\n\n", (unsigned long long)total,
+           (double)total / C64_CLOCK, (double)total / (C64_LINE_CYCLES * C64_FRAME_LINES));
+    printf("%12s %7s %10s  %s\n", "cycles", "%", "calls", "function");
+    for (int i = 0; i < n; ++i)
+    {
+        int f = order[i] / 2, q = order[i] % 2;
+        uint64_t c = fn_cycles[f][q];
+        char calls[24] = "-";
+        if (!q)
+            snprintf(calls, sizeof(calls), "%llu", (unsigned long long)fn_calls[f]);
+        printf("%12llu %6.2f%% %10s  %s%s\n", (unsigned long long)c, 100.0 * c / total,
+               calls, function_name(f), q ? " (in IRQ)" : "");
+    }
+}
+
+static void print_instruction(c64 *m, uint16_t pc)
+{
+    char text[32], where[MAX_NAME + 8];
+    int f = function_of(m, pc);
+
+    cpu_disasm(&m->cpu, pc, text, sizeof(text));
+    if (f < MAX_SYMBOLS)
+        snprintf(where, sizeof(where), "%s+%u", syms[f].name, (unsigned int)(pc - syms[f].start));
+    else
+        snprintf(where, sizeof(where), "%s", function_name(f));
+
+    printf("  %04X  %-28s %-16s %10llu %12llu %6.2f%%\n", pc, where, text,
+           (unsigned long long)pc_count[pc], (unsigned long long)pc_cycles[pc], 100.0 * pc_cycles[pc] / total);
+}
+
+static void print_hot(c64 *m, int top)
+{
+    static uint16_t order[0x10000];
+    int n = 0;
+
+    for (int pc = 0; pc < 0x10000; ++pc)
+        if (pc_cycles[pc])
+            order[n++] = (uint16_t)pc;
+
+    printf("\nHot instructions\n\n  %-4s  %-28s %-16s %10s %12s %7s\n", "addr", "where", "instruction", "execs", "cycles", "%");
+    for (int k = 0; k < top && k < n; ++k)
+    {
+        // Selection of the k-th largest
+        int best = k;
+        for (int i = k + 1; i < n; ++i)
+            if (pc_cycles[order[i]] > pc_cycles[order[best]])
+                best = i;
+        uint16_t t = order[k];
+        order[k] = order[best];
+        order[best] = t;
+
+        print_instruction(m, order[k]);
+    }
+}
+
+// Every instruction of one function in address order, with its share
+static void print_function(c64 *m, const char *name)
+{
+    for (int i = 0; i < nsyms; ++i)
+    {
+        if (strcmp(syms[i].name, name))
+            continue;
+
+        uint32_t end = syms[i].end ? syms[i].end : (i + 1 < nsyms ? syms[i + 1].start : 0x10000);
+        printf("\n%s\n\n", name);
+        for (uint32_t pc = syms[i].start; pc < end; )
+        {
+            char text[32];
+            int len = cpu_disasm(&m->cpu, (uint16_t)pc, text, sizeof(text));
+            print_instruction(m, (uint16_t)pc);
+            pc += (uint32_t)len;
+        }
+        return;
+    }
+
+    fprintf(stderr, "no function %s\n", name);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: c64prof [-k kernal.rom] [-b basic.rom] [-g chargen.rom] [-t keys]\n"
+                    "               [-c cycles] [-l file.lbl] [-m file.map] [-n top] [-f function] life.prg\n");
+    exit(2);
+}
+
+// file.prg -> file.ext
+static void sibling(char *dst, size_t size, const char *prg, const char *ext)
+{
+    snprintf(dst, size, "%s", prg);
+    char *dot = strrchr(dst, '.');
+    if (dot && !strchr(dot, '/'))
+        *dot = 0;
+    strncat(dst, ext, size - strlen(dst) - 1);
+}
+
+int main(int argc, char **argv)
+{
+    static c64 m;
+    const char *kernal = NULL, *basic = NULL, *chargen = NULL, *lbl = NULL, *map = NULL, *prg = NULL, *func = NULL;
+    int top = 30;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *a = argv[i];
+        if (a[0] != '-')
+        {
+            if (prg)
+                usage();
+            prg = a;
+            continue;
+        }
+        if (a[2] || i + 1 >= argc)
+            usage();
+
+        const char *v = argv[++i];
+        switch (a[1])
+        {
+            case 'k': kernal = v; break;
+            case 'b': basic = v; break;
+            case 'g': chargen = v; break;
+            case 't': keys = v; break;
+            case 'c': limit = strtoull(v, NULL, 0); break;
+            case 'l': lbl = v; break;
+            case 'm': map = v; break;
+            case 'n': top = atoi(v); break;
+            case 'f': func = v; break;
+            default:  usage();
+        }
+    }
+    if (!prg)
+        usage();
+
+    c64_init(&m);
+    m.mark = mark;
+
+    if ((kernal && !(m.has_kernal = c64_load_rom(kernal, m.kernal, sizeof(m.kernal)))) ||
+        (basic && !(m.has_basic = c64_load_rom(basic, m.basic, sizeof(m.basic)))) ||
+        (chargen && !(m.has_chargen = c64_load_rom(chargen, m.chargen, sizeof(m.chargen)))))
+    {
+        fprintf(stderr, "bad ROM image\n");
+        return 1;
+    }
+
+    if (m.has_kernal && !c64_kernal_init(&m))
+    {
+        fprintf(stderr, "KERNAL init did not return\n");
+        return 1;
+    }
+    if (*keys && !m.has_kernal)
+    {
+        fprintf(stderr, "-t needs a KERNAL image (-k)\n");
+        return 1;
+    }
+
+    char path[1024];
+    if (!lbl)
+        sibling(path, sizeof(path), prg, ".lbl"), lbl = path;
+    if (!load_lbl(lbl))
+        fprintf(stderr, "%s: no labels, everything is [unknown]\n", lbl);
+    if (!map)
+        sibling(path, sizeof(path), prg, ".map"), map = path;
+    load_map(map);
+    build_sym_at();
+
+    uint16_t sys;
+    if (!c64_load_prg(&m, prg, &sys) || !sys)
+    {
+        fprintf(stderr, "%s: cannot load, or no SYS line\n", prg);
+        return 1;
+    }
+
+    m.trace = trace;
+    c64_call(&m, sys, UINT64_MAX / 2, &finished);
+
+    if (m.cpu.jammed)
+        fprintf(stderr, "cpu jammed at $%04X\n", m.cpu.pc);
+    if (!total)
+    {
+        fprintf(stderr, "nothing profiled\n");
+        return 1;
+    }
+
+    print_flat();
+    print_hot(&m, top);
+    if (func)
+        print_function(&m, func);
+
+    return 0;
+}
@@ -0,0 +1,414 @@
+// Cycle-counting 6502 core for the host tools
+// One table gives the instruction, addressing mode and base cycles of each
+// documented opcode; reads through abs,X / abs,Y / (zp),Y add a cycle when
+// they cross a page, and taken branches add one more (two across a page).
+
+#include <stdio.h>
+#include "cpu6502.h"
+
+enum
+{
+    I_NONE,
+    I_ADC, I_AND, I_ASL, I_BCC, I_BCS, I_BEQ, I_BIT, I_BMI, I_BNE, I_BPL, I_BRK, I_BVC, I_BVS, I_CLC,
+    I_CLD, I_CLI, I_CLV, I_CMP, I_CPX, I_CPY, I_DEC, I_DEX, I_DEY, I_EOR, I_INC, I_INX, I_INY, I_JMP,
+    I_JSR, I_LDA, I_LDX, I_LDY, I_LSR, I_NOP, I_ORA, I_PHA, I_PHP, I_PLA, I_PLP, I_ROL, I_ROR, I_RTI,
+    I_RTS, I_SBC, I_SEC, I_SED, I_SEI, I_STA, I_STX, I_STY, I_TAX, I_TAY, I_TSX, I_TXA, I_TXS, I_TYA
+};
+
+static const char names[][4] =
+{
+    "???",
+    "ADC", "AND", "ASL", "BCC", "BCS", "BEQ", "BIT", "BMI", "BNE", "BPL", "BRK", "BVC", "BVS", "CLC",
+    "CLD", "CLI", "CLV", "CMP", "CPX", "CPY", "DEC", "DEX", "DEY", "EOR", "INC", "INX", "INY", "JMP",
+    "JSR", "LDA", "LDX", "LDY", "LSR", "NOP", "ORA", "PHA", "PHP", "PLA", "PLP", "ROL", "ROR", "RTI",
+    "RTS", "SBC", "SEC", "SED", "SEI", "STA", "STX", "STY", "TAX", "TAY", "TSX", "TXA", "TXS", "TYA"
+};
+
+enum
+{
+    M_IMP, M_ACC, M_IMM, M_ZP, M_ZPX, M_ZPY, M_ABS, M_ABX, M_ABY, M_IND, M_IZX, M_IZY, M_REL
+};
+
+typedef struct opinfo
+{
+    uint8_t ins, mode, cycles, page;    // page: +1 cycle when the read crosses a page
+} opinfo;
+
+static const opinfo ops[256] =
+{
+    [0x00] = {I_BRK, M_IMP, 7, 0}, [0x01] = {I_ORA, M_IZX, 6, 0}, [0x05] = {I_ORA, M_ZP,  3, 0}, [0x06] = {I_ASL, M_ZP,  5, 0},
+    [0x08] = {I_PHP, M_IMP, 3, 0}, [0x09] = {I_ORA, M_IMM, 2, 0}, [0x0A] = {I_ASL, M_ACC, 2, 0}, [0x0D] = {I_ORA, M_ABS, 4, 0},
+    [0x0E] = {I_ASL, M_ABS, 6, 0}, [0x10] = {I_BPL, M_REL, 2, 0}, [0x11] = {I_ORA, M_IZY, 5, 1}, [0x15] = {I_ORA, M_ZPX, 4, 0},
+    [0x16] = {I_ASL, M_ZPX, 6, 0}, [0x18] = {I_CLC, M_IMP, 2, 0}, [0x19] = {I_ORA, M_ABY, 4, 1}, [0x1D] = {I_ORA, M_ABX, 4, 1},
+    [0x1E] = {I_ASL, M_ABX, 7, 0}, [0x20] = {I_JSR, M_ABS, 6, 0}, [0x21] = {I_AND, M_IZX, 6, 0}, [0x24] = {I_BIT, M_ZP,  3, 0},
+    [0x25] = {I_AND, M_ZP,  3, 0}, [0x26] = {I_ROL, M_ZP,  5, 0}, [0x28] = {I_PLP, M_IMP, 4, 0}, [0x29] = {I_AND, M_IMM, 2, 0},
+    [0x2A] = {I_ROL, M_ACC, 2, 0}, [0x2C] = {I_BIT, M_ABS, 4, 0}, [0x2D] = {I_AND, M_ABS, 4, 0}, [0x2E] = {I_ROL, M_ABS, 6, 0},
+    [0x30] = {I_BMI, M_REL, 2, 0}, [0x31] = {I_AND, M_IZY, 5, 1}, [0x35] = {I_AND, M_ZPX, 4, 0}, [0x36] = {I_ROL, M_ZPX, 6, 0},
+    [0x38] = {I_SEC, M_IMP, 2, 0}, [0x39] = {I_AND, M_ABY, 4, 1}, [0x3D] = {I_AND, M_ABX, 4, 1}, [0x3E] = {I_ROL, M_ABX, 7, 0},
+    [0x40] = {I_RTI, M_IMP, 6, 0}, [0x41] = {I_EOR, M_IZX, 6, 0}, [0x45] = {I_EOR, M_ZP,  3, 0}, [0x46] = {I_LSR, M_ZP,  5, 0},
+    [0x48] = {I_PHA, M_IMP, 3, 0}, [0x49] = {I_EOR, M_IMM, 2, 0}, [0x4A] = {I_LSR, M_ACC, 2, 0}, [0x4C] = {I_JMP, M_ABS, 3, 0},
+    [0x4D] = {I_EOR, M_ABS, 4, 0}, [0x4E] = {I_LSR, M_ABS, 6, 0}, [0x50] = {I_BVC, M_REL, 2, 0}, [0x51] = {I_EOR, M_IZY, 5, 1},
+    [0x55] = {I_EOR, M_ZPX, 4, 0}, [0x56] = {I_LSR, M_ZPX, 6, 0}, [0x58] = {I_CLI, M_IMP, 2, 0}, [0x59] = {I_EOR, M_ABY, 4, 1},
+    [0x5D] = {I_EOR, M_ABX, 4, 1}, [0x5E] = {I_LSR, M_ABX, 7, 0}, [0x60] = {I_RTS, M_IMP, 6, 0}, [0x61] = {I_ADC, M_IZX, 6, 0},
+    [0x65] = {I_ADC, M_ZP,  3, 0}, [0x66] = {I_ROR, M_ZP,  5, 0}, [0x68] = {I_PLA, M_IMP, 4, 0}, [0x69] = {I_ADC, M_IMM, 2, 0},
+    [0x6A] = {I_ROR, M_ACC, 2, 0}, [0x6C] = {I_JMP, M_IND, 5, 0}, [0x6D] = {I_ADC, M_ABS, 4, 0}, [0x6E] = {I_ROR, M_ABS, 6, 0},
+    [0x70] = {I_BVS, M_REL, 2, 0}, [0x71] = {I_ADC, M_IZY, 5, 1}, [0x75] = {I_ADC, M_ZPX, 4, 0}, [0x76] = {I_ROR, M_ZPX, 6, 0},
+    [0x78] = {I_SEI, M_IMP, 2, 0}, [0x79] = {I_ADC, M_ABY, 4, 1}, [0x7D] = {I_ADC, M_ABX, 4, 1}, [0x7E] = {I_ROR, M_ABX, 7, 0},
+    [0x81] = {I_STA, M_IZX, 6, 0}, [0x84] = {I_STY, M_ZP,  3, 0}, [0x85] = {I_STA, M_ZP,  3, 0}, [0x86] = {I_STX, M_ZP,  3, 0},
+    [0x88] = {I_DEY, M_IMP, 2, 0}, [0x8A] = {I_TXA, M_IMP, 2, 0}, [0x8C] = {I_STY, M_ABS, 4, 0}, [0x8D] = {I_STA, M_ABS, 4, 0},
+    [0x8E] = {I_STX, M_ABS, 4, 0}, [0x90] = {I_BCC, M_REL, 2, 0}, [0x91] = {I_STA, M_IZY, 6, 0}, [0x94] = {I_STY, M_ZPX, 4, 0},
+    [0x95] = {I_STA, M_ZPX, 4, 0}, [0x96] = {I_STX, M_ZPY, 4, 0}, [0x98] = {I_TYA, M_IMP, 2, 0}, [0x99] = {I_STA, M_ABY, 5, 0},
+    [0x9A] = {I_TXS, M_IMP, 2, 0}, [0x9D] = {I_STA, M_ABX, 5, 0}, [0xA0] = {I_LDY, M_IMM, 2, 0}, [0xA1] = {I_LDA, M_IZX, 6, 0},
+    [0xA2] = {I_LDX, M_IMM, 2, 0}, [0xA4] = {I_LDY, M_ZP,  3, 0}, [0xA5] = {I_LDA, M_ZP,  3, 0}, [0xA6] = {I_LDX, M_ZP,  3, 0},
+    [0xA8] = {I_TAY, M_IMP, 2, 0}, [0xA9] = {I_LDA, M_IMM, 2, 0}, [0xAA] = {I_TAX, M_IMP, 2, 0}, [0xAC] = {I_LDY, M_ABS, 4, 0},
+    [0xAD] = {I_LDA, M_ABS, 4, 0}, [0xAE] = {I_LDX, M_ABS, 4, 0}, [0xB0] = {I_BCS, M_REL, 2, 0}, [0xB1] = {I_LDA, M_IZY, 5, 1},
+    [0xB4] = {I_LDY, M_ZPX, 4, 0}, [0xB5] = {I_LDA, M_ZPX, 4, 0}, [0xB6] = {I_LDX, M_ZPY, 4, 0}, [0xB8] = {I_CLV, M_IMP, 2, 0},
+    [0xB9] = {I_LDA, M_ABY, 4, 1}, [0xBA] = {I_TSX, M_IMP, 2, 0}, [0xBC] = {I_LDY, M_ABX, 4, 1}, [0xBD] = {I_LDA, M_ABX, 4, 1},
+    [0xBE] = {I_LDX, M_ABY, 4, 1}, [0xC0] = {I_CPY, M_IMM, 2, 0}, [0xC1] = {I_CMP, M_IZX, 6, 0}, [0xC4] = {I_CPY, M_ZP,  3, 0},
+    [0xC5] = {I_CMP, M_ZP,  3, 0}, [0xC6] = {I_DEC, M_ZP,  5, 0}, [0xC8] = {I_INY, M_IMP, 2, 0}, [0xC9] = {I_CMP, M_IMM, 2, 0},
+    [0xCA] = {I_DEX, M_IMP, 2, 0}, [0xCC] = {I_CPY, M_ABS, 4, 0}, [0xCD] = {I_CMP, M_ABS, 4, 0}, [0xCE] = {I_DEC, M_ABS, 6, 0},
+    [0xD0] = {I_BNE, M_REL, 2, 0}, [0xD1] = {I_CMP, M_IZY, 5, 1}, [0xD5] = {I_CMP, M_ZPX, 4, 0}, [0xD6] = {I_DEC, M_ZPX, 6, 0},
+    [0xD8] = {I_CLD, M_IMP, 2, 0}, [0xD9] = {I_CMP, M_ABY, 4, 1}, [0xDD] = {I_CMP, M_ABX, 4, 1}, [0xDE] = {I_DEC, M_ABX, 7, 0},
+    [0xE0] = {I_CPX, M_IMM, 2, 0}, [0xE1] = {I_SBC, M_IZX, 6, 0}, [0xE4] = {I_CPX, M_ZP,  3, 0}, [0xE5] = {I_SBC, M_ZP,  3, 0},
+    [0xE6] = {I_INC, M_ZP,  5, 0}, [0xE8] = {I_INX, M_IMP, 2, 0}, [0xE9] = {I_SBC, M_IMM, 2, 0}, [0xEA] = {I_NOP, M_IMP, 2, 0},
+    [0xEC] = {I_CPX, M_ABS, 4, 0}, [0xED] = {I_SBC, M_ABS, 4, 0}, [0xEE] = {I_INC, M_ABS, 6, 0}, [0xF0] = {I_BEQ, M_REL, 2, 0},
+    [0xF1] = {I_SBC, M_IZY, 5, 1}, [0xF5] = {I_SBC, M_ZPX, 4, 0}, [0xF6] = {I_INC, M_ZPX, 6, 0}, [0xF8] = {I_SED, M_IMP, 2, 0},
+    [0xF9] = {I_SBC, M_ABY, 4, 1}, [0xFD] = {I_SBC, M_ABX, 4, 1}, [0xFE] = {I_INC, M_ABX, 7, 0},
+};
+
+static inline uint8_t rd(cpu6502 *c, uint16_t addr)
+{
+    return c->read(c->ctx, addr);
+}
+
+static inline void wr(cpu6502 *c, uint16_t addr, uint8_t v)
+{
+    c->write(c->ctx, addr, v);
+}
+
+static inline uint16_t rd16(cpu6502 *c, uint16_t addr)
+{
+    return (uint16_t)(rd(c, addr) | (rd(c, (uint16_t)(addr + 1)) << 8));
+}
+
+// Zero page pointer: the high byte wraps within page zero
+static inline uint16_t rd16_zp(cpu6502 *c, uint8_t zp)
+{
+    return (uint16_t)(rd(c, zp) | (rd(c, (uint8_t)(zp + 1)) << 8));
+}
+
+static inline void push(cpu6502 *c, uint8_t v)
+{
+    wr(c, (uint16_t)(0x0100 | c->s), v);
+    c->s--;
+}
+
+static inline uint8_t pull(cpu6502 *c)
+{
+    c->s++;
+    return rd(c, (uint16_t)(0x0100 | c->s));
+}
+
+static inline void set_nz(cpu6502 *c, uint8_t v)
+{
+    c->p = (uint8_t)((c->p & ~(FLAG_N | FLAG_Z)) | (v & FLAG_N) | (v ? 0 : FLAG_Z));
+}
+
+static inline void set_flag(cpu6502 *c, uint8_t flag, bool on)
+{
+    c->p = (uint8_t)(on ? (c->p | flag) : (c->p & ~flag));
+}
+
+// Indexed address, with the extra cycle if a read crosses a page
+static inline uint16_t indexed(cpu6502 *c, uint16_t base, uint8_t index, bool page)
+{
+    uint16_t ea = (uint16_t)(base + index);
+    if (page && ((base ^ ea) & 0xFF00))
+        c->cycles++;
+    return ea;
+}
+
+// NMOS ADC/SBC, including decimal mode (N, V and Z follow the binary result)
+static void adc(cpu6502 *c, uint8_t v)
+{
+    unsigned int carry = c->p & FLAG_C;
+    unsigned int sum = c->a + v + carry;
+
+    set_flag(c, FLAG_Z, !(sum & 0xFF));
+
+    if (c->p & FLAG_D)
+    {
+        unsigned int lo = (c->a & 0x0F) + (v & 0x0F) + carry;
+        unsigned int hi = (c->a & 0xF0) + (v & 0xF0);
+        if (lo > 0x09)
+        {
+            lo += 0x06;
+            hi += 0x10;
+        }
+        set_flag(c, FLAG_N, hi & 0x80);
+        set_flag(c, FLAG_V, ~(c->a ^ v) & (c->a ^ hi) & 0x80);
+        if (hi > 0x90)
+            hi += 0x60;
+        set_flag(c, FLAG_C, hi > 0xFF);
+        c->a = (uint8_t)((lo & 0x0F) | (hi & 0xF0));
+    }
+    else
+    {
+        set_flag(c, FLAG_C, sum > 0xFF);
+        set_flag(c, FLAG_V, ~(c->a ^ v) & (c->a ^ sum) & 0x80);
+        c->a = (uint8_t)sum;
+        set_nz(c, c->a);
+    }
+}
+
+static void sbc(cpu6502 *c, uint8_t v)
+{
+    unsigned int borrow = (c->p & FLAG_C) ? 0 : 1;
+    unsigned int diff = (unsigned int)(c->a - v - borrow);
+
+    set_flag(c, FLAG_C, diff < 0x100);
+    set_flag(c, FLAG_V, (c->a ^ v) & (c->a ^ diff) & 0x80);
+    set_nz(c, (uint8_t)diff);
+
+    if (c->p & FLAG_D)
+    {
+        int lo = (c->a & 0x0F) - (v & 0x0F) - (int)borrow;
+        int hi = (c->a >> 4) - (v >> 4);
+        if (lo < 0)
+        {
+            lo -= 6;
+            hi--;
+        }
+        if (hi < 0)
+            hi -= 6;
+        c->a = (uint8_t)(((hi & 0x0F) << 4) | (lo & 0x0F));
+    }
+    else
+        c->a = (uint8_t)diff;
+}
+
+static void compare(cpu6502 *c, uint8_t reg, uint8_t v)
+{
+    set_flag(c, FLAG_C, reg >= v);
+    set_nz(c, (uint8_t)(reg - v));
+}
+
+static void branch(cpu6502 *c, bool taken, uint8_t offset)
+{
+    if (!taken)
+        return;
+
+    uint16_t to = (uint16_t)(c->pc + (int8_t)offset);
+    c->cycles += ((to ^ c->pc) & 0xFF00) ? 2 : 1;
+    c->pc = to;
+}
+
+// Shifts and rotates, on A or memory
+static uint8_t shift(cpu6502 *c, uint8_t ins, uint8_t v)
+{
+    uint8_t carry_in = c->p & FLAG_C;
+
+    switch (ins)
+    {
+        case I_ASL: set_flag(c, FLAG_C, v & 0x80); v = (uint8_t)(v << 1); break;
+        case I_ROL: set_flag(c, FLAG_C, v & 0x80); v = (uint8_t)((v << 1) | carry_in); break;
+        case I_LSR: set_flag(c, FLAG_C, v & 0x01); v = (uint8_t)(v >> 1); break;
+        case I_ROR: set_flag(c, FLAG_C, v & 0x01); v = (uint8_t)((v >> 1) | (carry_in << 7)); break;
+    }
+
+    set_nz(c, v);
+    return v;
+}
+
+static void interrupt(cpu6502 *c, uint16_t vector, bool brk)
+{
+    push(c, (uint8_t)(c->pc >> 8));
+    push(c, (uint8_t)c->pc);
+    // B is only set in the pushed copy, and only by BRK
+    uint8_t p = (uint8_t)((c->p | FLAG_U) & ~FLAG_B);
+    push(c, brk ? (uint8_t)(p | FLAG_B) : p);
+    c->p |= FLAG_I;
+    c->pc = rd16(c, vector);
+}
+
+int cpu_step(cpu6502 *c)
+{
+    if (c->jammed)
+        return 0;
+
+    uint64_t start = c->cycles;
+
+    if (c->irq && !(c->p & FLAG_I))
+    {
+        interrupt(c, 0xFFFE, false);
+        c->cycles += 7;
+        return 7;
+    }
+
+    uint8_t op = rd(c, c->pc);
+    const opinfo *o = &ops[op];
+    if (o->ins == I_NONE)
+    {
+        c->jammed = true;
+        return 0;
+    }
+
+    c->pc++;
+    c->cycles += o->cycles;
+
+    // Effective address (or the operand itself for immediate/relative)
+    uint16_t ea = 0;
+    switch (o->mode)
+    {
+        case M_IMM:
+        case M_REL: ea = c->pc++; break;
+        case M_ZP:  ea = rd(c, c->pc++); break;
+        case M_ZPX: ea = (uint8_t)(rd(c, c->pc++) + c->x); break;
+        case M_ZPY: ea = (uint8_t)(rd(c, c->pc++) + c->y); break;
+        case M_ABS: ea = rd16(c, c->pc); c->pc += 2; break;
+        case M_ABX: ea = indexed(c, rd16(c, c->pc), c->x, o->page); c->pc += 2; break;
+        case M_ABY: ea = indexed(c, rd16(c, c->pc), c->y, o->page); c->pc += 2; break;
+        case M_IZX: ea = rd16_zp(c, (uint8_t)(rd(c, c->pc++) + c->x)); break;
+        case M_IZY: ea = indexed(c, rd16_zp(c, rd(c, c->pc++)), c->y, o->page); break;
+        case M_IND:
+        {
+            // JMP ($xxFF) takes the high byte from $xx00
+            uint16_t ptr = rd16(c, c->pc);
+            c->pc += 2;
+            ea = (uint16_t)(rd(c, ptr) | (rd(c, (uint16_t)((ptr & 0xFF00) | ((ptr + 1) & 0xFF))) << 8));
+        } break;
+        default:
+            break;
+    }
+
+    switch (o->ins)
+    {
+        case I_LDA: c->a = rd(c, ea); set_nz(c, c->a); break;
+        case I_LDX: c->x = rd(c, ea); set_nz(c, c->x); break;
+        case I_LDY: c->y = rd(c, ea); set_nz(c, c->y); break;
+        case I_STA: wr(c, ea, c->a); break;
+        case I_STX: wr(c, ea, c->x); break;
+        case I_STY: wr(c, ea, c->y); break;
+
+        case I_ADC: adc(c, rd(c, ea)); break;
+        case I_SBC: sbc(c, rd(c, ea)); break;
+        case I_AND: c->a &= rd(c, ea); set_nz(c, c->a); break;
+        case I_ORA: c->a |= rd(c, ea); set_nz(c, c->a); break;
+        case I_EOR: c->a ^= rd(c, ea); set_nz(c, c->a); break;
+        case I_CMP: compare(c, c->a, rd(c, ea)); break;
+        case I_CPX: compare(c, c->x, rd(c, ea)); break;
+        case I_CPY: compare(c, c->y, rd(c, ea)); break;
+        case I_BIT:
+        {
+            uint8_t v = rd(c, ea);
+            c->p = (uint8_t)((c->p & ~(FLAG_N | FLAG_V | FLAG_Z)) | (v & (FLAG_N | FLAG_V)) | ((c->a & v) ? 0 : FLAG_Z));
+        } break;
+
+        case I_ASL:
+        case I_ROL:
+        case I_LSR:
+        case I_ROR:
+            if (o->mode == M_ACC)
+                c->a = shift(c, o->ins, c->a);
+            else
+            {
+                // Read-modify-write stores the old value first, as the NMOS part does
+                uint8_t v = rd(c, ea);
+                wr(c, ea, v);
+                wr(c, ea, shift(c, o->ins, v));
+            }
+            break;
+
+        case I_INC:
+        case I_DEC:
+        {
+            uint8_t v = rd(c, ea);
+            wr(c, ea, v);
+            v = (uint8_t)((o->ins == I_INC) ? v + 1 : v - 1);
+            wr(c, ea, v);
+            set_nz(c, v);
+        } break;
+
+        case I_INX: c->x++; set_nz(c, c->x); break;
+        case I_INY: c->y++; set_nz(c, c->y); break;
+        case I_DEX: c->x--; set_nz(c, c->x); break;
+        case I_DEY: c->y--; set_nz(c, c->y); break;
+        case I_TAX: c->x = c->a; set_nz(c, c->x); break;
+        case I_TAY: c->y = c->a; set_nz(c, c->y); break;
+        case I_TXA: c->a = c->x; set_nz(c, c->a); break;
+        case I_TYA: c->a = c->y; set_nz(c, c->a); break;
+        case I_TSX: c->x = c->s; set_nz(c, c->x); break;
+        case I_TXS: c->s = c->x; break;
+
+        case I_PHA: push(c, c->a); break;
+        case I_PHP: push(c, (uint8_t)(c->p | FLAG_B | FLAG_U)); break;
+        case I_PLA: c->a = pull(c); set_nz(c, c->a); break;
+        case I_PLP: c->p = (uint8_t)((pull(c) & ~FLAG_B) | FLAG_U); break;
+
+        case I_CLC: c->p &= (uint8_t)~FLAG_C; break;
+        case I_SEC: c->p |= FLAG_C; break;
+        case I_CLI: c->p &= (uint8_t)~FLAG_I; break;
+        case I_SEI: c->p |= FLAG_I; break;
+        case I_CLD: c->p &= (uint8_t)~FLAG_D; break;
+        case I_SED: c->p |= FLAG_D; break;
+        case I_CLV: c->p &= (uint8_t)~FLAG_V; break;
+        case I_NOP: break;
+
+        case I_BPL: branch(c, !(c->p & FLAG_N), rd(c, ea)); break;
+        case I_BMI: branch(c,  (c->p & FLAG_N), rd(c, ea)); break;
+        case I_BVC: branch(c, !(c->p & FLAG_V), rd(c, ea)); break;
+        case I_BVS: branch(c,  (c->p & FLAG_V), rd(c, ea)); break;
+        case I_BCC: branch(c, !(c->p & FLAG_C), rd(c, ea)); break;
+        case I_BCS: branch(c,  (c->p & FLAG_C), rd(c, ea)); break;
+        case I_BNE: branch(c, !(c->p & FLAG_Z), rd(c, ea)); break;
+        case I_BEQ: branch(c,  (c->p & FLAG_Z), rd(c, ea)); break;
+
+        case I_JMP: c->pc = ea; break;
+        case I_JSR:
+            c->pc--;
+            push(c, (uint8_t)(c->pc >> 8));
+            push(c, (uint8_t)c->pc);
+            c->pc = ea;
+            break;
+        case I_RTS:
+            c->pc = pull(c);
+            c->pc = (uint16_t)((c->pc | (pull(c) << 8)) + 1);
+            break;
+        case I_RTI:
+            c->p = (uint8_t)((pull(c) & ~FLAG_B) | FLAG_U);
+            c->pc = pull(c);
+            c->pc = (uint16_t)(c->pc | (pull(c) << 8));
+            break;
+        case I_BRK:
+            c->pc++;                                // skip the padding byte
+            interrupt(c, 0xFFFE, true);
+            break;
+    }
+
+    return (int)(c->cycles - start);
+}
+
+int cpu_disasm(cpu6502 *c, uint16_t addr, char *buf, int size)
+{
+    const opinfo *o = &ops[rd(c, addr)];
+    uint8_t b1 = rd(c, (uint16_t)(addr + 1));
+    uint16_t w = (uint16_t)(b1 | (rd(c, (uint16_t)(addr + 2)) << 8));
+    const char *n = names[o->ins];
+
+    switch (o->ins == I_NONE ? M_IMP : o->mode)
+    {
+        case M_ACC: snprintf(buf, (size_t)size, "%s A", n); return 1;
+        case M_IMM: snprintf(buf, (size_t)size, "%s #$%02X", n, b1); return 2;
+        case M_ZP:  snprintf(buf, (size_t)size, "%s $%02X", n, b1); return 2;
+        case M_ZPX: snprintf(buf, (size_t)size, "%s $%02X,X", n, b1); return 2;
+        case M_ZPY: snprintf(buf, (size_t)size, "%s $%02X,Y", n, b1); return 2;
+        case M_IZX: snprintf(buf, (size_t)size, "%s ($%02X,X)", n, b1); return 2;
+        case M_IZY: snprintf(buf, (size_t)size, "%s ($%02X),Y", n, b1); return 2;
+        case M_REL: snprintf(buf, (size_t)size, "%s $%04X", n, (uint16_t)(addr + 2 + (int8_t)b1)); return 2;
+        case M_ABS: snprintf(buf, (size_t)size, "%s $%04X", n, w); return 3;
+        case M_ABX: snprintf(buf, (size_t)size, "%s $%04X,X", n, w); return 3;
+        case M_ABY: snprintf(buf, (size_t)size, "%s $%04X,Y", n, w); return 3;
+        case M_IND: snprintf(buf, (size_t)size, "%s ($%04X)", n, w); return 3;
+        default:    snprintf(buf, (size_t)size, "%s", n); return 1;
+    }
+}
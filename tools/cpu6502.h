@@ -0,0 +1,43 @@
+// Cycle-counting 6502 core for the host tools (documented opcodes only)
+// Memory goes through the read/write callbacks; each step runs one
+// instruction (or takes a pending IRQ) and adds its exact cycle count,
+// including page-crossing and taken-branch penalties.
+
+#ifndef CPU6502_H
+#define CPU6502_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Status flags
+#define FLAG_C 0x01
+#define FLAG_Z 0x02
+#define FLAG_I 0x04
+#define FLAG_D 0x08
+#define FLAG_B 0x10
+#define FLAG_U 0x20
+#define FLAG_V 0x40
+#define FLAG_N 0x80
+
+typedef struct cpu6502
+{
+    uint16_t pc;
+    uint8_t  a, x, y, s, p;
+    uint64_t cycles;
+    bool     irq;           // IRQ line, level triggered, set by the machine
+    bool     jammed;        // hit an undocumented opcode, pc points at it
+
+    void    *ctx;
+    uint8_t (*read)(void *ctx, uint16_t addr);
+    void    (*write)(void *ctx, uint16_t addr, uint8_t v);
+} cpu6502;
+
+// Run one instruction, or take the IRQ if the line is up and I is clear.
+// Returns the cycles used (0 if the cpu is jammed).
+int cpu_step(cpu6502 *c);
+
+// Disassemble the instruction at addr into buf (via the read callback);
+// returns its length in bytes
+int cpu_disasm(cpu6502 *c, uint16_t addr, char *buf, int size);
+
+#endif
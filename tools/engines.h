@@ -0,0 +1,23 @@
+// Engine ids and sizes shared by the host tools, in the order of the
+// engine enum in src/life.h
+
+#ifndef ENGINES_H
+#define ENGINES_H
+
+#include "life.h"
+
+static const char * const engine_ids[ENGINE_COUNT] = { "naive", "separable", "bitpack", "dirty", "events", "edge", "universe", "hires", "quad", "inplace" };
+
+// Cells each engine updates per generation
+static inline long engine_cells(unsigned char e)
+{
+    switch (e)
+    {
+        case ENGINE_UNIVERSE: return (long)UWIDTH * UHEIGHT;
+        case ENGINE_HIRES:    return (long)HWIDTH * HHEIGHT;
+        case ENGINE_QUAD:     return (long)QWIDTH * QHEIGHT;
+        default:              return (long)WIDTH * HEIGHT;
+    }
+}
+
+#endif